@@ -3,8 +3,7 @@
 #include <iostream>
 #include <utility>
 
-#include "Event.h"
-#include "Level.h"
+#include "EventBus.h"
 
 Animation::Animation() = default;
 
@@ -67,7 +66,7 @@ bool Animation::fireEventAndReturnTrueIfFinished() const
     const auto result = mSpriteIndex == mActionRectangles.size() - 1;
     if (result && !mName.empty() && !mRepeat)
     {
-        addEvent(Event::constructAnimationCompleted(mName));
+        publishEvent(Event::AnimationCompleted{mName});
     }
     return result;
 }
@@ -117,3 +116,29 @@ void Animation::switchPalette(const sf::Vector2f& offset,
     mHeight = size.y;
     mActionRectangles = generateActionRectangles();
 }
+
+AnimationState Animation::saveState() const
+{
+    return {static_cast<uint32_t>(mRemainingTicsThisFrame),
+            static_cast<uint32_t>(mSpriteIndex),
+            static_cast<uint16_t>(mXOffset),
+            static_cast<uint16_t>(mYOffset),
+            static_cast<uint16_t>(mWidth),
+            static_cast<uint16_t>(mHeight)};
+}
+
+void Animation::restoreState(const AnimationState& state)
+{
+    // Compare as saved: animations without a palette keep the builder's
+    // placeholder offsets, which don't fit but are never switched either
+    if (state.xOffset != static_cast<uint16_t>(mXOffset) ||
+        state.yOffset != static_cast<uint16_t>(mYOffset) ||
+        state.width != static_cast<uint16_t>(mWidth) ||
+        state.height != static_cast<uint16_t>(mHeight))
+    {
+        switchPalette(sf::Vector2f(state.xOffset, state.yOffset),
+                      sf::Vector2f(state.width, state.height));
+    }
+    mRemainingTicsThisFrame = state.remainingTicsThisFrame;
+    mSpriteIndex = state.spriteIndex;
+}
@@ -7,6 +7,8 @@
 #include <cstdlib>
 #include <memory>
 
+#include "SaveState.h"
+
 class AnimationBuilder;
 
 class Animation
@@ -38,6 +40,9 @@ public:
 
     void switchPalette(const sf::Vector2f& offset, const sf::Vector2f& size);
 
+    [[nodiscard]] AnimationState saveState() const;
+    void restoreState(const AnimationState& state);
+
 private:
     size_t mRemainingTicsThisFrame;
     size_t mTicsPerFrame;
@@ -0,0 +1,275 @@
+#include "BroadPhase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "JobSystem.h"
+
+namespace
+{
+// Two tiles, so most entities cover at most four cells
+const float CELL_SIZE = 32;
+
+const size_t GRAIN_SIZE = 256;
+
+int32_t toCell(float coordinate)
+{
+    return static_cast<int32_t>(std::floor(coordinate / CELL_SIZE));
+}
+
+uint64_t cellKey(int32_t x, int32_t y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+           static_cast<uint32_t>(y);
+}
+}
+
+bool BroadPhase::Bounds::overlaps(const Bounds& other) const
+{
+    // Touching counts, to stay on the safe side of the narrow phase
+    return !isEmpty && !other.isEmpty && left <= other.right &&
+           other.left <= right && top <= other.bottom && other.top <= bottom;
+}
+
+bool BroadPhase::Bounds::contains(const Bounds& other) const
+{
+    if (other.isEmpty)
+        return true;
+    return !isEmpty && left <= other.left && other.right <= right &&
+           top <= other.top && other.bottom <= bottom;
+}
+
+bool BroadPhase::CellEntry::operator<(const CellEntry& other) const
+{
+    return cell < other.cell || (cell == other.cell && index < other.index);
+}
+
+BroadPhase::Bounds BroadPhase::boundsOf(const ProjectedHitboxes& hitboxes)
+{
+    Bounds bounds{0, 0, 0, 0, true};
+    const auto include = [&bounds](const Hitbox& hitbox)
+    {
+        // Invalid hitboxes collide with nothing
+        if (!hitbox.mIsValid)
+            return;
+        // The same sums as Hitbox::getLeft() and the rest, worked out here
+        // since this runs for every active entity every frame
+        const auto hitboxLeft =
+                hitbox.mEntityPosition.x + hitbox.mUpperLeftOffset.x;
+        const auto hitboxTop =
+                hitbox.mEntityPosition.y + hitbox.mUpperLeftOffset.y;
+        const auto hitboxRight = hitboxLeft + hitbox.mSize.x;
+        const auto hitboxBottom = hitboxTop + hitbox.mSize.y;
+        const auto left = std::min(hitboxLeft, hitboxRight);
+        const auto right = std::max(hitboxLeft, hitboxRight);
+        const auto top = std::min(hitboxTop, hitboxBottom);
+        const auto bottom = std::max(hitboxTop, hitboxBottom);
+        if (bounds.isEmpty)
+        {
+            bounds = Bounds{left, top, right, bottom, false};
+            return;
+        }
+        bounds.left = std::min(bounds.left, left);
+        bounds.right = std::max(bounds.right, right);
+        bounds.top = std::min(bounds.top, top);
+        bounds.bottom = std::max(bounds.bottom, bottom);
+    };
+    // The moves along x and y span the whole move, and sweeping from the
+    // start along it stays inside them too
+    for (size_t ii = 0; ii < 2; ++ii)
+    {
+        include(hitboxes.start[ii]);
+        include(hitboxes.x[ii]);
+        include(hitboxes.y[ii]);
+    }
+    return bounds;
+}
+
+template <typename Visit>
+void BroadPhase::forEachCell(const Bounds& bounds, Visit visit)
+{
+    if (bounds.isEmpty)
+        return;
+    const auto lastX = toCell(bounds.right);
+    const auto lastY = toCell(bounds.bottom);
+    for (auto x = toCell(bounds.left); x <= lastX; ++x)
+    {
+        for (auto y = toCell(bounds.top); y <= lastY; ++y)
+            visit(cellKey(x, y));
+    }
+}
+
+const std::vector<BroadPhase::Pair>& BroadPhase::findPairs(
+        const BoundsLanes& bounds,
+        const std::vector<EntityType>& types,
+        const std::vector<char>& awake,
+        size_t count,
+        JobSystem& jobSystem)
+{
+    // A copy, since the caller keeps updating its bounds as entities move
+    mBounds.resize(count);
+    for (size_t ii = 0; ii < count; ++ii)
+        mBounds[ii] = bounds.get(ii);
+
+    // Only the awake entities go in the grid, since pairs of sleeping
+    // entities are never tested
+    mGrid.clear();
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        if (!awake[ii])
+            continue;
+        forEachCell(mBounds[ii],
+                    [this, ii](uint64_t cell)
+                    { mGrid.push_back({cell, static_cast<uint32_t>(ii)}); });
+    }
+    std::sort(mGrid.begin(), mGrid.end());
+
+    // Every entity looks for awake partners. A pair of awake entities is
+    // reported by the one with the smaller index, and a sleeping entity
+    // reports all of its partners.
+    const auto numChunks = JobSystem::countChunks(count, GRAIN_SIZE);
+    mChunkPairs.resize(std::max(mChunkPairs.size(), numChunks));
+    jobSystem.parallelFor(
+            count,
+            GRAIN_SIZE,
+            [&](size_t begin, size_t end, size_t chunk)
+            {
+                auto& pairs = mChunkPairs[chunk];
+                pairs.clear();
+                for (auto ii = begin; ii < end; ++ii)
+                {
+                    const auto& collidesWithType =
+                            COLLISION_MATRIX[static_cast<size_t>(types[ii])];
+                    forEachCell(
+                            mBounds[ii],
+                            [&](uint64_t cell)
+                            {
+                                auto entry = std::lower_bound(
+                                        mGrid.begin(),
+                                        mGrid.end(),
+                                        CellEntry{cell, 0});
+                                for (; entry != mGrid.end() &&
+                                       entry->cell == cell;
+                                     ++entry)
+                                {
+                                    const auto jj = entry->index;
+                                    if (jj == ii || (awake[ii] && jj < ii))
+                                        continue;
+                                    if (!collidesWithType[static_cast<size_t>(
+                                                types[jj])] ||
+                                        !mBounds[ii].overlaps(mBounds[jj]))
+                                        continue;
+                                    pairs.emplace_back(
+                                            std::min<uint32_t>(ii, jj),
+                                            std::max<uint32_t>(ii, jj));
+                                }
+                            });
+                }
+            });
+
+    // Entities sharing more than one cell are found once per cell
+    mPairs.clear();
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+        mPairs.insert(mPairs.end(),
+                      mChunkPairs[chunk].begin(),
+                      mChunkPairs[chunk].end());
+    std::sort(mPairs.begin(), mPairs.end());
+    mPairs.erase(std::unique(mPairs.begin(), mPairs.end()), mPairs.end());
+    return mPairs;
+}
+
+bool BroadPhase::isInsideBounds(size_t index, const Bounds& bounds) const
+{
+    return mBounds[index].contains(bounds);
+}
+
+void BoundsLanes::resize(size_t count)
+{
+    const auto numBlocks = (count + LANES - 1) / LANES;
+    mBlocks.resize(numBlocks);
+    // Whatever the padding lanes held, they must not match anything
+    for (auto index = count; index < numBlocks * LANES; ++index)
+        set(index, BroadPhase::Bounds{0, 0, 0, 0, true});
+}
+
+void BoundsLanes::set(size_t index, const BroadPhase::Bounds& bounds)
+{
+    auto& block = mBlocks[index / LANES];
+    const auto lane = index % LANES;
+    if (bounds.isEmpty)
+    {
+        const auto infinity = std::numeric_limits<float>::infinity();
+        block.left[lane] = infinity;
+        block.top[lane] = infinity;
+        block.right[lane] = -infinity;
+        block.bottom[lane] = -infinity;
+        return;
+    }
+    block.left[lane] = bounds.left;
+    block.top[lane] = bounds.top;
+    block.right[lane] = bounds.right;
+    block.bottom[lane] = bounds.bottom;
+}
+
+BroadPhase::Bounds BoundsLanes::get(size_t index) const
+{
+    const auto& block = mBlocks[index / LANES];
+    const auto lane = index % LANES;
+    const BroadPhase::Bounds bounds{block.left[lane],
+                                    block.top[lane],
+                                    block.right[lane],
+                                    block.bottom[lane],
+                                    false};
+    // Inside-out bounds are the empty ones
+    if (bounds.left > bounds.right)
+        return BroadPhase::Bounds{0, 0, 0, 0, true};
+    return bounds;
+}
+
+size_t BoundsLanes::getNumBlocks() const
+{
+    return mBlocks.size();
+}
+
+uint32_t BoundsLanes::overlapMask(size_t block,
+                                  const BroadPhase::Bounds& bounds) const
+{
+    if (bounds.isEmpty)
+        return 0;
+    const auto& lanes = mBlocks[block];
+    uint32_t mask = 0;
+#if defined(__SSE2__)
+    // Four lanes per compare; the sign bits of the result are their bits
+    const auto left = _mm_set1_ps(bounds.left);
+    const auto top = _mm_set1_ps(bounds.top);
+    const auto right = _mm_set1_ps(bounds.right);
+    const auto bottom = _mm_set1_ps(bounds.bottom);
+    for (size_t lane = 0; lane < LANES; lane += 4)
+    {
+        const auto touchesX =
+                _mm_and_ps(_mm_cmple_ps(left, _mm_load_ps(lanes.right + lane)),
+                           _mm_cmple_ps(_mm_load_ps(lanes.left + lane), right));
+        const auto touchesY = _mm_and_ps(
+                _mm_cmple_ps(top, _mm_load_ps(lanes.bottom + lane)),
+                _mm_cmple_ps(_mm_load_ps(lanes.top + lane), bottom));
+        mask |= static_cast<uint32_t>(
+                        _mm_movemask_ps(_mm_and_ps(touchesX, touchesY)))
+                << lane;
+    }
+#else
+    for (size_t lane = 0; lane < LANES; ++lane)
+    {
+        const auto touches = (bounds.left <= lanes.right[lane]) &
+                             (lanes.left[lane] <= bounds.right) &
+                             (bounds.top <= lanes.bottom[lane]) &
+                             (lanes.top[lane] <= bounds.bottom);
+        mask |= static_cast<uint32_t>(touches) << lane;
+    }
+#endif
+    return mask;
+}
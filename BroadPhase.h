@@ -0,0 +1,123 @@
+#ifndef SUPERMARIOBROS_BROADPHASE_H
+#define SUPERMARIOBROS_BROADPHASE_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Entity.h"
+
+class BoundsLanes;
+class JobSystem;
+
+/*
+ * Finds the pairs of entities that might collide this frame, so that the
+ * narrow phase does not have to test every pair.
+ *
+ * Each entity gets bounds covering all of its projected hitboxes, which is
+ * everywhere the narrow phase could see it this frame. The awake entities
+ * are binned into a uniform grid and every entity looks up the cells its
+ * bounds cover. A pair is kept if the bounds overlap, the types can
+ * collide and at least one of the two is awake.
+ *
+ * Collision responses move entities after the pairs have been found. An
+ * entity whose hitboxes are still inside its bounds cannot have gained a
+ * partner; one that left them has to be tested against everything again.
+ */
+class BroadPhase
+{
+public:
+    using Pair = std::pair<uint32_t, uint32_t>;
+
+    // Everywhere an entity's projected hitboxes reach this frame
+    struct Bounds
+    {
+        float left;
+        float top;
+        float right;
+        float bottom;
+        bool isEmpty;
+
+        [[nodiscard]] bool overlaps(const Bounds& other) const;
+        [[nodiscard]] bool contains(const Bounds& other) const;
+    };
+
+    static Bounds boundsOf(const ProjectedHitboxes& hitboxes);
+
+    /*
+     * The first count entries of bounds and types describe the entities;
+     * awake says which of them are awake. Returns the pairs with the smaller
+     * index first, sorted, which is the order the narrow phase tests them in.
+     */
+    const std::vector<Pair>& findPairs(
+            const BoundsLanes& bounds,
+            const std::vector<EntityType>& types,
+            const std::vector<char>& awake,
+            size_t count,
+            JobSystem& jobSystem);
+
+    // Whether the entity, now within bounds, can still only touch the
+    // partners found for it
+    [[nodiscard]] bool isInsideBounds(size_t index,
+                                      const Bounds& bounds) const;
+
+private:
+    struct CellEntry
+    {
+        uint64_t cell;
+        uint32_t index;
+
+        bool operator<(const CellEntry& other) const;
+    };
+
+    template <typename Visit>
+    static void forEachCell(const Bounds& bounds, Visit visit);
+
+    std::vector<Bounds> mBounds;
+    std::vector<CellEntry> mGrid;
+    std::vector<std::vector<Pair>> mChunkPairs;
+    std::vector<Pair> mPairs;
+};
+
+/*
+ * Entity bounds in blocks of LANES entities, with one array per edge inside
+ * a block, so that one entity is tested against a whole block at once in
+ * vector registers. The narrow phase uses it to skip the pairs that cannot
+ * touch before looking at any hitbox.
+ *
+ * Empty bounds, and the lanes past the last entity, are stored inside out,
+ * which no test passes. Overlap is inclusive, like Bounds::overlaps().
+ */
+class BoundsLanes
+{
+public:
+    static const size_t LANES = 8;
+
+    void resize(size_t count);
+
+    void set(size_t index, const BroadPhase::Bounds& bounds);
+
+    [[nodiscard]] BroadPhase::Bounds get(size_t index) const;
+
+    [[nodiscard]] size_t getNumBlocks() const;
+
+    /*
+     * One bit per lane of the block whose bounds touch the given ones,
+     * lane 0 in the lowest bit
+     */
+    [[nodiscard]] uint32_t overlapMask(size_t block,
+                                       const BroadPhase::Bounds& bounds) const;
+
+private:
+    struct alignas(32) Block
+    {
+        float left[LANES];
+        float top[LANES];
+        float right[LANES];
+        float bottom[LANES];
+    };
+
+    std::vector<Block> mBlocks;
+};
+
+#endif  // SUPERMARIOBROS_BROADPHASE_H
@@ -1,9 +1,15 @@
 #include "Entity.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
 #include <utility>
 
 #include "Level.h"
 #include "SFML/Graphics.hpp"
+#include "SaveState.h"
+#include "Timer.h"
 
 namespace
 {
@@ -42,6 +48,12 @@ const std::vector<EntitySide> SIDES{EntitySide::LEFT,
                                     EntitySide::BOTTOM,
                                     EntitySide::TOP};
 
+// Levels in a LevelBatch spawn entities from several threads at once
+std::atomic<uint32_t> nextEntityId(0);
+
+// Entities that don't respond to anything
+constexpr CollisionHandlers NO_COLLISION_HANDLERS{};
+
 const std::vector<EntityCorner> CORNERS{EntityCorner::UPPER_LEFT,
                                         EntityCorner::UPPER_RIGHT,
                                         EntityCorner::LOWER_RIGHT,
@@ -67,37 +79,6 @@ std::string convertSideToString(EntitySide side)
     throw std::runtime_error("Failed to match EntitySide");
 }
 
-bool isEnemy(EntityType type)
-{
-    switch (type)
-    {
-    case EntityType::GOOMBA:
-        return true;
-    default:
-        return false;
-    }
-}
-
-bool isObject(EntityType type)
-{
-    switch (type)
-    {
-    case EntityType::BLOCK:
-    case EntityType::PIPE:
-    case EntityType::GROUND:
-        return true;
-    default:
-        return false;
-    }
-}
-
-bool isMario(EntityType entityType)
-{
-    return entityType == EntityType::SMALL_MARIO ||
-            entityType == EntityType::BIG_MARIO ||
-            entityType == EntityType::FIRE_MARIO;
-}
-
 const float Entity::NO_MAX_VELOCITY_VALUE = -1;
 const float Entity::MAX_FALLING_VELOCITY = 4.5;
 
@@ -120,7 +101,9 @@ Entity::Entity(const sf::Texture& texture,
     mSpriteBoundsHitbox(createSpriteBoundsHitbox()),
     mInputEnabled(true),
     mLookDirection(1),
-    mType(type)
+    mType(type),
+    mCollisionHandlers(&NO_COLLISION_HANDLERS),
+    mId(nextEntityId++)
 {
     const sf::Vector2f upperLeftCorner(lowerLeftCorner.x,
                                        lowerLeftCorner.y + mSpriteHeight);
@@ -155,33 +138,36 @@ sf::Vector2f Entity::upperCenterToUpperLeft(
                        originalPosition.y);
 }
 
-Entity::~Entity() = default;
+Entity::~Entity()
+{
+    // Timer actions point at the entity, so they must not outlive it
+    getTimer().cancel(this);
+}
 
 EntityType Entity::getType() const
 {
     return mType;
 }
 
-Hitbox Entity::getProjectedYHitbox(EntityType type) const
+ProjectedHitboxes Entity::projectHitboxes() const
 {
     const auto currentPosition = sf::Vector2f(getLeft(), getBottom());
     const auto originalPosition = currentPosition - this->mDeltaP;
     const auto newYPosition =
             originalPosition + sf::Vector2f{0, this->mDeltaP.y};
-    Hitbox yHitbox(getHitbox(type));
-    yHitbox.setEntityPosition(newYPosition);
-    return yHitbox;
-}
-
-Hitbox Entity::getProjectedXHitbox(EntityType type) const
-{
-    const auto currentPosition = sf::Vector2f(getLeft(), getBottom());
-    const auto originalPosition = currentPosition - this->mDeltaP;
     const auto newXPosition =
             originalPosition + sf::Vector2f{this->mDeltaP.x, 0};
-    Hitbox xHitbox(getHitbox(type));
-    xHitbox.setEntityPosition(newXPosition);
-    return xHitbox;
+
+    ProjectedHitboxes projected{{mSpriteBoundsHitbox, mMarioCollisionHitbox},
+                                {mSpriteBoundsHitbox, mMarioCollisionHitbox},
+                                {mSpriteBoundsHitbox, mMarioCollisionHitbox}};
+    for (auto& hitbox : projected.y)
+        hitbox.setEntityPosition(newYPosition);
+    for (auto& hitbox : projected.x)
+        hitbox.setEntityPosition(newXPosition);
+    for (auto& hitbox : projected.start)
+        hitbox.setEntityPosition(originalPosition);
+    return projected;
 }
 
 const Hitbox& Entity::getHitbox(EntityType type) const
@@ -196,64 +182,157 @@ const Hitbox& Entity::getHitbox(EntityType type) const
     }
 }
 
+bool Entity::usesMarioCollisionHitbox(EntityType type) const
+{
+    return &getHitbox(type) == &mMarioCollisionHitbox;
+}
+
 bool Entity::detectCollision(Entity& other)
+{
+    if (!canCollide(getType(), other.getType()))
+        return false;
+    CollisionRecord record;
+    if (!findCollision(other, projectHitboxes(), other.projectHitboxes(),
+                       record))
+        return false;
+    resolveCollision(record);
+    return true;
+}
+
+bool Entity::findCollision(Entity& other,
+                           const ProjectedHitboxes& hitboxes,
+                           const ProjectedHitboxes& otherHitboxes,
+                           CollisionRecord& record)
 {
     if (mDeltaP.x == 0 && mDeltaP.y == 0 &&
         (other.mDeltaP.x != 0 || other.mDeltaP.y != 0))
     {
-        return other.detectCollision(*this);
+        return other.findCollision(*this, otherHitboxes, hitboxes, record);
     }
 
-    const auto yHitbox = getProjectedYHitbox(other.getType());
-    if (yHitbox.collidesWith(other.getProjectedYHitbox(mType)))
+    const auto mine = usesMarioCollisionHitbox(other.getType());
+    const auto theirs = other.usesMarioCollisionHitbox(mType);
+    const auto& otherHitbox =
+            theirs ? other.mMarioCollisionHitbox : other.mSpriteBoundsHitbox;
+    const auto& start = hitboxes.start[mine];
+    const auto& otherStart = otherHitboxes.start[theirs];
+    const auto delta = mDeltaP - other.mDeltaP;
+
+    // When the two first touched, for ordering an entity's collisions
+    const auto timeOfImpact = [&]
+    {
+        float time;
+        EntitySide side;
+        return start.sweepInto(otherStart, delta, time, side) ? time : 0.f;
+    };
+
+    if (hitboxes.y[mine].collidesWith(otherHitboxes.y[theirs]))
     {
-        handleCollision(
+        record = CollisionRecord{
+                this,
                 Collision{
                         &other,
                         mDeltaP.y > 0 ? EntitySide::BOTTOM : EntitySide::TOP,
-                        mDeltaP.y > 0 ? other.getHitbox(mType).getTop()
-                                      : other.getHitbox(mType).getBottom(),
+                        mDeltaP.y > 0 ? otherHitbox.getTop()
+                                      : otherHitbox.getBottom(),
                         0,
                 },
-                other);
+                timeOfImpact(),
+        };
         return true;
     }
 
-    const auto xHitbox = getProjectedXHitbox(other.getType());
-    if (xHitbox.collidesWith(other.getHitbox(mType)))
-
+    if (hitboxes.x[mine].collidesWith(otherHitbox))
     {
-        handleCollision(
+        record = CollisionRecord{
+                this,
                 Collision{
                         &other,
                         mDeltaP.x > 0 ? EntitySide::RIGHT : EntitySide::LEFT,
                         0,
-                        mDeltaP.x > 0 ? other.getHitbox(mType).getLeft()
-                                      : other.getHitbox(mType).getRight(),
+                        mDeltaP.x > 0 ? otherHitbox.getLeft()
+                                      : otherHitbox.getRight(),
                 },
-                other);
+                timeOfImpact(),
+        };
         return true;
     }
 
-    return false;
+    // Both projections miss a hitbox that was passed straight through.
+    // Ending the frame clear of it on the far side takes a movement longer
+    // than the two hitboxes together along that axis, so shorter ones are
+    // left alone; a hitbox only cut into at the corner is still overlapped
+    // at the start of the next frame, and the projections take it from
+    // there. Of the rest, only a hitbox within the area swept this frame
+    // can have been crossed.
+    const auto sweptLeft = start.getLeft() + std::min(delta.x, 0.f);
+    const auto sweptRight = start.getRight() + std::max(delta.x, 0.f);
+    const auto sweptTop = start.getTop() + std::min(delta.y, 0.f);
+    const auto sweptBottom = start.getBottom() + std::max(delta.y, 0.f);
+    if ((std::abs(delta.x) < start.mSize.x + otherStart.mSize.x &&
+         std::abs(delta.y) < start.mSize.y + otherStart.mSize.y) ||
+        sweptLeft >= otherStart.getRight() ||
+        sweptRight <= otherStart.getLeft() ||
+        sweptTop >= otherStart.getBottom() ||
+        sweptBottom <= otherStart.getTop())
+    {
+        return false;
+    }
+
+    float time;
+    EntitySide side;
+    if (!start.sweepInto(otherStart, delta, time, side))
+        return false;
+
+    Collision collision{&other, side, 0, 0};
+    switch (side)
+    {
+    case EntitySide::BOTTOM:
+        collision.yIntersection = otherHitbox.getTop();
+        break;
+    case EntitySide::TOP:
+        collision.yIntersection = otherHitbox.getBottom();
+        break;
+    case EntitySide::RIGHT:
+        collision.xIntersection = otherHitbox.getLeft();
+        break;
+    case EntitySide::LEFT:
+        collision.xIntersection = otherHitbox.getRight();
+        break;
+    }
+    record = CollisionRecord{this, collision, time, true};
+    return true;
+}
+
+void Entity::resolveCollision(const CollisionRecord& record)
+{
+    record.entity->handleCollision(record.collision, *record.collision.entity);
 }
 
 void Entity::handleCollision(Collision collision, Entity& entity)
 {
-    onCollision(Collision{collision.entity,
-                          collision.side,
+    // The second lookup has to wait, since the first response can change
+    // Mario's type
+    if (const auto handler =
+                (*mCollisionHandlers)[static_cast<size_t>(entity.mType)])
+        handler(*this, collision);
+    if (const auto handler =
+                (*entity.mCollisionHandlers)[static_cast<size_t>(mType)])
+        handler(entity,
+                Collision{this,
+                          oppositeSide(collision.side),
                           collision.yIntersection,
                           collision.xIntersection});
-    entity.onCollision(Collision{this,
-                                 oppositeSide(collision.side),
-                                 collision.yIntersection,
-                                 collision.xIntersection});
 }
 
-void Entity::onCollision(const Collision& collision)
+void Entity::setCollisionHandlers(const CollisionHandlers& handlers)
 {
-    // do nothing
-    (void)collision;
+    mCollisionHandlers = &handlers;
+}
+
+void Entity::setType(EntityType type)
+{
+    mType = type;
 }
 
 void Entity::clampX(float spriteX, float newSpriteX)
@@ -283,6 +362,11 @@ bool Entity::collideWithEntity(std::unique_ptr<Entity>& entity)
     return detectCollision(*entity);
 }
 
+bool Entity::collideWithEntity(Entity& entity)
+{
+    return detectCollision(entity);
+}
+
 void Entity::updateAnimation()
 {
     setAnimationFromState();
@@ -295,13 +379,16 @@ void Entity::setAnimationFromState()
     // Do nothing
 }
 
-void Entity::draw(sf::RenderWindow& window)
+void Entity::draw(sf::RenderTarget& target)
 {
-    setPosition(getX(), sfmlYToScreenY(getY()));
-    window.draw(mActiveSprite);
-    setPosition(getX(), screenYToSfmlY(getY()));
+    // Restore the exact position afterwards so that drawing never perturbs
+    // the simulation (replays run without drawing)
+    const auto position = mActiveSprite.getPosition();
+    mActiveSprite.setPosition(position.x, sfmlYToScreenY(position.y));
+    target.draw(mActiveSprite);
+    mActiveSprite.setPosition(position);
     if (std::getenv("DRAW_HITBOX") != nullptr)
-        mMarioCollisionHitbox.draw(window);
+        mMarioCollisionHitbox.draw(target);
 }
 
 float Entity::sfmlYToScreenY(float y) const
@@ -362,6 +449,12 @@ sf::Vector2f Entity::getAcceleration() const
     return mAcceleration;
 }
 
+bool Entity::isAsleep() const
+{
+    return mVelocity.x == 0 && mVelocity.y == 0 && mAcceleration.x == 0 &&
+           mAcceleration.y == 0;
+}
+
 void Entity::terminate()
 {
 }
@@ -453,12 +546,104 @@ bool Entity::needsCleanup()
     return mCleanupFlag;
 }
 
-void Entity::dispatchEvent(const Event& event)
+void Entity::setMaxVelocity(float maxVelocity)
 {
-    addEvent(event);
+    mMaxVelocity = maxVelocity;
 }
 
-void Entity::setMaxVelocity(float maxVelocity)
+uint32_t Entity::getId() const
 {
-    mMaxVelocity = maxVelocity;
+    return mId;
+}
+
+namespace
+{
+HitboxState saveHitbox(const Hitbox& hitbox)
+{
+    return {hitbox.mSize,
+            hitbox.mUpperLeftOffset,
+            hitbox.mEntityPosition,
+            hitbox.mIsValid};
+}
+
+void restoreHitbox(Hitbox& hitbox, const HitboxState& state)
+{
+    hitbox.mSize = state.size;
+    hitbox.mUpperLeftOffset = state.upperLeftOffset;
+    hitbox.mEntityPosition = state.entityPosition;
+    hitbox.mIsValid = state.isValid;
+}
+}
+
+void Entity::saveState(EntityState& state) const
+{
+    state.id = mId;
+    state.changingDirection = mChangingDirection;
+    state.cleanupFlag = mCleanupFlag;
+    state.inputEnabled = mInputEnabled;
+    state.lookDirection = mLookDirection;
+    state.position = mActiveSprite.getPosition();
+    state.scale = mActiveSprite.getScale();
+    state.textureRect = mActiveSprite.getTextureRect();
+    state.velocity = mVelocity;
+    state.acceleration = mAcceleration;
+    state.deltaP = mDeltaP;
+    state.maxVelocity = mMaxVelocity;
+    state.spriteWidth = static_cast<uint16_t>(mSpriteWidth);
+    state.spriteHeight = static_cast<uint16_t>(mSpriteHeight);
+    state.marioCollisionHitbox = saveHitbox(mMarioCollisionHitbox);
+    state.spriteBoundsHitbox = saveHitbox(mSpriteBoundsHitbox);
+    state.activeAnimation = EntityState::NO_ANIMATION;
+    state.numAnimations = 0;
+    state.anchor = 0;
+    state.flags = 0;
+    state.frame = {};
+}
+
+void Entity::restoreState(const EntityState& state)
+{
+    mId = state.id;
+    mChangingDirection = state.changingDirection;
+    mCleanupFlag = state.cleanupFlag;
+    mInputEnabled = state.inputEnabled;
+    mLookDirection = state.lookDirection;
+    mActiveSprite.setPosition(state.position);
+    mActiveSprite.setScale(state.scale);
+    mActiveSprite.setTextureRect(state.textureRect);
+    mVelocity = state.velocity;
+    mAcceleration = state.acceleration;
+    mDeltaP = state.deltaP;
+    mMaxVelocity = state.maxVelocity;
+    mSpriteWidth = state.spriteWidth;
+    mSpriteHeight = state.spriteHeight;
+    restoreHitbox(mMarioCollisionHitbox, state.marioCollisionHitbox);
+    restoreHitbox(mSpriteBoundsHitbox, state.spriteBoundsHitbox);
+}
+
+void Entity::saveAnimations(
+        EntityState& state,
+        std::initializer_list<const Animation*> animations) const
+{
+    assert(animations.size() <= EntityState::MAX_ANIMATIONS);
+    for (const auto* animation : animations)
+    {
+        if (animation == mActiveAnimation)
+            state.activeAnimation = state.numAnimations;
+        state.animations[state.numAnimations++] = animation->saveState();
+    }
+}
+
+void Entity::restoreAnimations(const EntityState& state,
+                               std::initializer_list<Animation*> animations)
+{
+    assert(animations.size() == state.numAnimations);
+    mActiveAnimation = nullptr;
+    uint8_t index = 0;
+    for (auto* animation : animations)
+    {
+        animation->restoreState(state.animations[index]);
+        if (index == state.activeAnimation)
+            mActiveAnimation = animation;
+        ++index;
+    }
 }
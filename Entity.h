@@ -2,7 +2,10 @@
 #define SUPERMARIOBROS_ENTITY_H
 
 #include <SFML/System.hpp>
+#include <array>
+#include <cstdint>
 #include <cstdlib>
+#include <initializer_list>
 #include <memory>
 
 #include "Animation.h"
@@ -11,7 +14,7 @@
 
 #define GRIDBOX_SIZE 16
 
-class Event;
+struct EntityState;
 
 enum class EntityType
 {
@@ -29,10 +32,108 @@ enum class EntityType
     FIREBALL,
 };
 
+// FIREBALL must stay the last type
+constexpr size_t NUM_ENTITY_TYPES =
+        static_cast<size_t>(EntityType::FIREBALL) + 1;
+
 std::string convertSideToString(EntitySide side);
-bool isEnemy(EntityType type);
-bool isMario(EntityType entityType);
-bool isObject(EntityType entityType);
+
+constexpr bool isEnemy(EntityType type)
+{
+    switch (type)
+    {
+    case EntityType::GOOMBA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr bool isObject(EntityType type)
+{
+    switch (type)
+    {
+    case EntityType::BLOCK:
+    case EntityType::PIPE:
+    case EntityType::GROUND:
+        return true;
+    default:
+        return false;
+    }
+}
+
+constexpr bool isMario(EntityType entityType)
+{
+    return entityType == EntityType::SMALL_MARIO ||
+           entityType == EntityType::BIG_MARIO ||
+           entityType == EntityType::FIRE_MARIO;
+}
+
+/*
+ * Whether an entity of the given type does anything when it touches an
+ * entity of the other type. Every collision handler table is checked
+ * against this at compile time.
+ */
+constexpr bool respondsToCollision(EntityType type, EntityType other)
+{
+    switch (type)
+    {
+    case EntityType::GOOMBA:
+        return isMario(other) || isObject(other) ||
+               other == EntityType::FIREBALL;
+    case EntityType::SMALL_MARIO:
+    case EntityType::BIG_MARIO:
+    case EntityType::FIRE_MARIO:
+        return isEnemy(other) || isObject(other) ||
+               other == EntityType::MUSHROOM ||
+               other == EntityType::FIREFLOWER;
+    case EntityType::BLOCK:
+    case EntityType::FIREFLOWER:
+        return isMario(other);
+    case EntityType::MUSHROOM:
+        return isMario(other) || isObject(other);
+    case EntityType::FIREBALL:
+        return isEnemy(other) || isObject(other);
+    default:
+        return false;
+    }
+}
+
+using CollisionMatrix =
+        std::array<std::array<bool, NUM_ENTITY_TYPES>, NUM_ENTITY_TYPES>;
+
+constexpr CollisionMatrix buildCollisionMatrix()
+{
+    CollisionMatrix matrix{};
+    for (size_t ii = 0; ii < NUM_ENTITY_TYPES; ++ii)
+    {
+        for (size_t jj = 0; jj < NUM_ENTITY_TYPES; ++jj)
+        {
+            const auto type = static_cast<EntityType>(ii);
+            const auto other = static_cast<EntityType>(jj);
+            matrix[ii][jj] = respondsToCollision(type, other) ||
+                             respondsToCollision(other, type);
+        }
+    }
+    return matrix;
+}
+
+constexpr CollisionMatrix COLLISION_MATRIX = buildCollisionMatrix();
+
+/*
+ * Whether a collision between the two types can have any effect. Pairs
+ * that can't are skipped before any hitbox is looked at.
+ */
+constexpr bool canCollide(EntityType type, EntityType other)
+{
+    return COLLISION_MATRIX[static_cast<size_t>(type)]
+                           [static_cast<size_t>(other)];
+}
+
+static_assert(!canCollide(EntityType::GROUND, EntityType::PIPE),
+              "Scenery never collides with scenery");
+static_assert(canCollide(EntityType::GROUND, EntityType::GOOMBA),
+              "Goombas walk on the ground");
 
 class Entity;
 
@@ -44,6 +145,113 @@ struct Collision
     float xIntersection;
 };
 
+/*
+ * A collision that has been detected but not responded to yet. entity is
+ * the one whose movement ran into collision.entity, and collision is from
+ * its side.
+ */
+struct CollisionRecord
+{
+    Entity* entity;
+    Collision collision;
+
+    // The fraction of the frame's movement at which the two first touch; 0
+    // if they already overlapped at the start of the frame
+    float timeOfImpact = 0;
+
+    // Found by sweeping the movement, because entity passed clean through
+    // collision.entity and ended the frame clear of it
+    bool isSwept = false;
+};
+
+/*
+ * Collision response for one entity class, indexed by the type of the
+ * entity it touched. A handler is passed the entity that owns the table; a
+ * null entry means the class ignores that type.
+ */
+using CollisionHandler = void (*)(Entity& self, const Collision& collision);
+using CollisionHandlers = std::array<CollisionHandler, NUM_ENTITY_TYPES>;
+
+// Picks the handler for every type matching a trait, or for one type
+class CollisionRule
+{
+public:
+    constexpr CollisionRule(bool (*matches)(EntityType),
+                            CollisionHandler handler) :
+        mMatches(matches),
+        mType(),
+        mHandler(handler)
+    {
+    }
+
+    constexpr CollisionRule(EntityType type, CollisionHandler handler) :
+        mMatches(nullptr),
+        mType(type),
+        mHandler(handler)
+    {
+    }
+
+    [[nodiscard]] constexpr bool matches(EntityType type) const
+    {
+        return mMatches ? mMatches(type) : type == mType;
+    }
+
+    [[nodiscard]] constexpr CollisionHandler getHandler() const
+    {
+        return mHandler;
+    }
+
+private:
+    bool (*mMatches)(EntityType);
+    EntityType mType;
+    CollisionHandler mHandler;
+};
+
+// Each type gets the handler of the first rule it matches
+constexpr CollisionHandlers makeCollisionHandlers(
+        std::initializer_list<CollisionRule> rules)
+{
+    CollisionHandlers handlers{};
+    for (size_t ii = 0; ii < NUM_ENTITY_TYPES; ++ii)
+    {
+        for (const auto& rule : rules)
+        {
+            if (rule.matches(static_cast<EntityType>(ii)))
+            {
+                handlers[ii] = rule.getHandler();
+                break;
+            }
+        }
+    }
+    return handlers;
+}
+
+// Whether a table responds to exactly the types respondsToCollision() lists
+constexpr bool agreesWithCollisionMatrix(const CollisionHandlers& handlers,
+                                         EntityType type)
+{
+    for (size_t ii = 0; ii < NUM_ENTITY_TYPES; ++ii)
+    {
+        if ((handlers[ii] != nullptr) !=
+            respondsToCollision(type, static_cast<EntityType>(ii)))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * An entity's hitboxes moved by only the y or only the x part of this
+ * frame's movement, which is what the narrow phase tests, and where they
+ * were before moving. Each array is indexed by whether it holds the Mario
+ * collision hitbox.
+ */
+struct ProjectedHitboxes
+{
+    Hitbox y[2];
+    Hitbox x[2];
+    Hitbox start[2];
+};
+
 class Entity
 {
 public:
@@ -75,10 +283,20 @@ public:
     void setAcceleration(const sf::Vector2f& newAcceleration);
     void updatePosition();
     virtual void doInternalCalculations();
+
+    /*
+     * With no velocity and no acceleration there is nothing to integrate,
+     * so Level skips updatePosition() and doInternalCalculations() and only
+     * tests the entity against awake ones. It wakes up as soon as anything
+     * (a collision, a timer or an event handler) moves it again; woken by
+     * another entity's collision, it meets other sleepers from the next
+     * frame.
+     */
+    [[nodiscard]] bool isAsleep() const;
     void addPositionDelta(float deltaX, float deltaY);
 
     void updateAnimation();
-    virtual void draw(sf::RenderWindow& window);
+    virtual void draw(sf::RenderTarget& target);
 
     virtual void terminate();
 
@@ -89,19 +307,48 @@ public:
 
     sf::Vector2f mDeltaP;
 
-    [[nodiscard]] virtual EntityType getType() const;
+    [[nodiscard]] EntityType getType() const;
 
     bool collideWithEntity(std::vector<std::unique_ptr<Entity>>& entities);
     bool collideWithEntity(std::unique_ptr<Entity>& entity);
+    bool collideWithEntity(Entity& entity);
+
+    /*
+     * Detection without the response: fills in record if the two entities
+     * collide this frame. Neither entity is changed, so pairs that share no
+     * entity can be tested at the same time.
+     */
+    bool findCollision(Entity& other,
+                       const ProjectedHitboxes& hitboxes,
+                       const ProjectedHitboxes& otherHitboxes,
+                       CollisionRecord& record);
+
+    // Run both entities' handlers for a collision found by findCollision()
+    static void resolveCollision(const CollisionRecord& record);
+
+    [[nodiscard]] ProjectedHitboxes projectHitboxes() const;
 
     virtual void setPosition(float x, float y);
 
     void setMaxVelocity(float maxVelocity);
 
+    // Unique for the lifetime of the program; survives save states
+    [[nodiscard]] uint32_t getId() const;
+
+    /*
+     * Copy everything that changes after construction into state, or back.
+     * Subclasses add their kind, animations and own fields.
+     */
+    virtual void saveState(EntityState& state) const;
+    virtual void restoreState(const EntityState& state);
+
 protected:
     bool detectCollision(Entity& other);
 
-    virtual void onCollision(const Collision& collision);
+    // Subclasses that respond to collisions install their table here
+    void setCollisionHandlers(const CollisionHandlers& handlers);
+
+    void setType(EntityType type);
 
     void clampX(float spriteX, float newSpriteX);
 
@@ -110,14 +357,18 @@ protected:
     void handleCollision(Collision collision, Entity& entity);
 
     virtual const Hitbox& getHitbox(EntityType type) const;
-    Hitbox getProjectedYHitbox(EntityType type) const;
-    Hitbox getProjectedXHitbox(EntityType type) const;
+    [[nodiscard]] bool usesMarioCollisionHitbox(EntityType type) const;
 
     Hitbox createSpriteBoundsHitbox() const;
 
     void updateHitboxPositions();
 
-    void dispatchEvent(const Event& event);
+    // Save the given animations, and which of them is active, in order
+    void saveAnimations(EntityState& state,
+                        std::initializer_list<const Animation*> animations)
+            const;
+    void restoreAnimations(const EntityState& state,
+                           std::initializer_list<Animation*> animations);
 
     sf::Sprite mActiveSprite;
     sf::Vector2f mVelocity;
@@ -156,6 +407,10 @@ private:
 
 
     EntityType mType;
+
+    const CollisionHandlers* mCollisionHandlers;
+
+    uint32_t mId;
 };
 
 #endif  // SUPERMARIOBROS_ENTITY_H
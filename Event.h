@@ -3,68 +3,43 @@
 
 #include <Entity.h>
 
-#include <variant>
-
-enum class EventType
+#include <string>
+
+/*
+ * The events entities raise for the rest of the game. Each one travels on
+ * its own channel of the EventBus, so a new event is a new struct here plus
+ * an entry in the bus's channel list.
+ */
+namespace Event
+{
+struct PointsEarned
 {
-    POINTS_EARNED,
-    ITEM_SPAWNED,
-    BLOCK_SHATTERED,
-    ANIMATION_COMPLETED,
-    FIREBALL_SPAWNED,
+    sf::Vector2f position;
+    int points;
 };
 
-class Event
+struct ItemSpawned
 {
-public:
-    EventType type;
-
-    static Event constructPointsEarned(const sf::Vector2f& position, int points);
-    static Event constructItemSpawned(EntityType type,
-                                      const sf::Vector2f& position,
-                                      float blockBottom);
-    static Event constructBlockShattered(const sf::Vector2f& position);
-    static Event constructAnimationCompleted(const std::string& animationType);
-    static Event constructFireball(const sf::Vector2f& position, int direction);
-
-    struct PointsEarned
-    {
-        sf::Vector2f position;
-        int points;
-    };
-
-    struct ItemSpawned
-    {
-        sf::Vector2f position;
-        EntityType type;
-        float blockTop;
-    };
-
-    struct BlockShattered
-    {
-        sf::Vector2f position;
-    };
-
-    struct AnimationCompleted
-    {
-        std::string animationType;
-    };
+    sf::Vector2f position;
+    EntityType type;
+    float blockTop;
+};
 
-    struct FireballSpawned
-    {
-	sf::Vector2f position;
-	int direction;
-    };
+struct BlockShattered
+{
+    sf::Vector2f position;
+};
 
-    [[nodiscard]] PointsEarned asPointsEarned() const;
-    [[nodiscard]] ItemSpawned asItemSpawned() const;
-    [[nodiscard]] BlockShattered asBlockShattered() const;
-    [[nodiscard]] AnimationCompleted asAnimationCompleted() const;
-    [[nodiscard]] FireballSpawned asFireballSpawned() const;
+struct AnimationCompleted
+{
+    std::string animationType;
+};
 
-private:
-    std::variant<PointsEarned, ItemSpawned, BlockShattered, AnimationCompleted, FireballSpawned>
-            eventData;
+struct FireballSpawned
+{
+    sf::Vector2f position;
+    int direction;
 };
+}
 
 #endif  // SUPERMARIOBROS_EVENT_H
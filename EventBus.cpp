@@ -0,0 +1,82 @@
+#include "EventBus.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "SimulationContext.h"
+
+namespace
+{
+EventBus gEventBus;
+}
+
+const size_t EventBus::MAX_DISPATCH_DEPTH = 4;
+
+thread_local EventBus::Stage* EventBus::tStage = nullptr;
+
+EventBus& getEventBus()
+{
+    if (const auto* context = getSimulationContext())
+        return *context->eventBus;
+    return gEventBus;
+}
+
+void EventBus::unsubscribe(const void* owner)
+{
+    std::apply([owner](auto&... channels)
+               { (channels.unsubscribe(owner), ...); },
+               mChannels);
+}
+
+void EventBus::dispatch()
+{
+    for (size_t depth = 0; depth < MAX_DISPATCH_DEPTH; ++depth)
+    {
+        bool dispatched = false;
+        std::apply([&dispatched](auto&... channels)
+                   { ((dispatched |= channels.dispatch()), ...); },
+                   mChannels);
+        if (!dispatched)
+            return;
+    }
+}
+
+void EventBus::clear()
+{
+    std::apply([](auto&... channels) { (channels.clear(), ...); },
+               mChannels);
+}
+
+void EventBus::setNumStages(size_t numStages)
+{
+    mStages.resize(numStages);
+    for (auto& stage : mStages)
+        stage.bus = this;
+}
+
+size_t EventBus::getNumStages() const
+{
+    return mStages.size();
+}
+
+void EventBus::mergeStages()
+{
+    for (auto& stage : mStages)
+    {
+        std::apply([this](auto&... events) { (mergeStaged(events), ...); },
+                   stage.events);
+    }
+}
+
+ScopedEventStage::ScopedEventStage(EventBus& bus, size_t stage) :
+    mPrevious(EventBus::tStage)
+{
+    if (stage >= bus.mStages.size())
+        throw std::runtime_error("No event stage " + std::to_string(stage));
+    EventBus::tStage = &bus.mStages[stage];
+}
+
+ScopedEventStage::~ScopedEventStage()
+{
+    EventBus::tStage = mPrevious;
+}
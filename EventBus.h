@@ -0,0 +1,230 @@
+#ifndef SUPERMARIOBROS_EVENTBUS_H
+#define SUPERMARIOBROS_EVENTBUS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Event.h"
+
+/*
+ * The events of one type raised since the last dispatch, stored next to
+ * each other. A subscriber gets all of them in one call, so it can reserve
+ * once and handle them in bulk.
+ *
+ * Events are published into a back buffer. Dispatch swaps it with the front
+ * buffer before calling the subscribers, so a subscriber may publish while
+ * its batch is being read; those events wait in the back buffer. Both
+ * buffers keep their capacity from frame to frame.
+ */
+template <typename T>
+class EventChannel
+{
+public:
+    using Subscriber = std::function<void(const std::vector<T>& events)>;
+
+    void publish(const T& event)
+    {
+        mEvents.push_back(event);
+    }
+
+    void publish(const std::vector<T>& events)
+    {
+        mEvents.insert(mEvents.end(), events.begin(), events.end());
+    }
+
+    // The owner lets every subscription of an object be dropped together
+    // when that object goes away
+    void subscribe(const Subscriber& subscriber, const void* owner)
+    {
+        mSubscriptions.push_back({subscriber, owner});
+    }
+
+    void unsubscribe(const void* owner)
+    {
+        mSubscriptions.erase(
+                std::remove_if(mSubscriptions.begin(),
+                               mSubscriptions.end(),
+                               [owner](const Subscription& subscription)
+                               { return subscription.owner == owner; }),
+                mSubscriptions.end());
+    }
+
+    /*
+     * Hand the pending events to every subscriber. Returns false, without
+     * calling anyone, if there were none.
+     */
+    bool dispatch()
+    {
+        if (mEvents.empty())
+            return false;
+        std::swap(mEvents, mDispatching);
+        for (const auto& subscription : mSubscriptions)
+            subscription.subscriber(mDispatching);
+        mDispatching.clear();
+        return true;
+    }
+
+    void clear()
+    {
+        mEvents.clear();
+    }
+
+    [[nodiscard]] const std::vector<T>& getPending() const
+    {
+        return mEvents;
+    }
+
+private:
+    struct Subscription
+    {
+        Subscriber subscriber;
+        const void* owner;
+    };
+
+    std::vector<T> mEvents;
+    std::vector<T> mDispatching;
+    std::vector<Subscription> mSubscriptions;
+};
+
+/*
+ * Every event type, in the order the bus dispatches them. A new event is
+ * added here.
+ */
+template <typename... Events>
+struct EventTypeList
+{
+    using Channels = std::tuple<EventChannel<Events>...>;
+    using Buffers = std::tuple<std::vector<Events>...>;
+};
+
+using EventTypes = EventTypeList<Event::FireballSpawned,
+                                 Event::PointsEarned,
+                                 Event::ItemSpawned,
+                                 Event::BlockShattered,
+                                 Event::AnimationCompleted>;
+
+/*
+ * One channel per event type. Events are queued as they are published and
+ * handed out once a frame by dispatch(), which goes through the channels in
+ * the order they are listed in EventTypes.
+ *
+ * The channels themselves are not thread safe. Worker threads publish into
+ * stages instead: each worker gets a stage of its own for the duration of
+ * a ScopedEventStage, so publishing needs no locks, and mergeStages() later
+ * moves the staged events onto the channels in stage order. As long as each
+ * stage is given the same share of the work every time, the merged order
+ * does not depend on how the threads were scheduled.
+ */
+class EventBus
+{
+public:
+    // How many rounds of events raised by subscribers one dispatch handles
+    static const size_t MAX_DISPATCH_DEPTH;
+
+    template <typename T>
+    [[nodiscard]] EventChannel<T>& channel()
+    {
+        return std::get<EventChannel<T>>(mChannels);
+    }
+
+    // Goes to the calling thread's stage if it has one on this bus
+    template <typename T>
+    void publish(const T& event)
+    {
+        if (tStage != nullptr && tStage->bus == this)
+            std::get<std::vector<T>>(tStage->events).push_back(event);
+        else
+            channel<T>().publish(event);
+    }
+
+    template <typename T>
+    void subscribe(const typename EventChannel<T>::Subscriber& subscriber,
+                   const void* owner)
+    {
+        channel<T>().subscribe(subscriber, owner);
+    }
+
+    // Drop the owner's subscriptions on every channel
+    void unsubscribe(const void* owner);
+
+    /*
+     * Go through the channels until none has anything pending. Events raised
+     * by subscribers are handled in the same dispatch, up to
+     * MAX_DISPATCH_DEPTH rounds; anything raised after that stays queued for
+     * the next one, so handlers that keep raising events cannot stall a
+     * frame.
+     */
+    void dispatch();
+
+    // Throw away everything published since the last dispatch
+    void clear();
+
+    /*
+     * Make room for numStages workers. Must not be called while any stage
+     * is in use.
+     */
+    void setNumStages(size_t numStages);
+
+    [[nodiscard]] size_t getNumStages() const;
+
+    /*
+     * Append what every stage collected to the channels, stage 0 first, and
+     * empty the stages. Call it from one thread once the workers are done.
+     */
+    void mergeStages();
+
+private:
+    friend class ScopedEventStage;
+
+    struct Stage
+    {
+        EventBus* bus = nullptr;
+        EventTypes::Buffers events;
+    };
+
+    template <typename T>
+    void mergeStaged(std::vector<T>& events)
+    {
+        channel<T>().publish(events);
+        events.clear();
+    }
+
+    // The stage the calling thread publishes into, if any
+    static thread_local Stage* tStage;
+
+    EventTypes::Channels mChannels;
+
+    std::vector<Stage> mStages;
+};
+
+/*
+ * Sends the calling thread's events on the bus to one of its stages until
+ * the scope ends
+ */
+class ScopedEventStage
+{
+public:
+    ScopedEventStage(EventBus& bus, size_t stage);
+    ~ScopedEventStage();
+
+    ScopedEventStage(const ScopedEventStage&) = delete;
+    ScopedEventStage& operator=(const ScopedEventStage&) = delete;
+
+private:
+    EventBus::Stage* mPrevious;
+};
+
+// The calling thread's SimulationContext's, if it has one
+EventBus& getEventBus();
+
+template <typename T>
+void publishEvent(const T& event)
+{
+    getEventBus().publish(event);
+}
+
+#endif  // SUPERMARIOBROS_EVENTBUS_H
@@ -1,7 +1,45 @@
 #include "Hitbox.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "SFML/Graphics.hpp"
 
+namespace
+{
+/*
+ * The fractions of delta at which the moving span [low, high] starts and
+ * stops overlapping [otherLow, otherHigh]. Returns false if a span that does
+ * not move never overlaps.
+ */
+bool sweepAxis(float low,
+               float high,
+               float otherLow,
+               float otherHigh,
+               float delta,
+               float& entry,
+               float& exit)
+{
+    if (delta == 0)
+    {
+        entry = -std::numeric_limits<float>::infinity();
+        exit = std::numeric_limits<float>::infinity();
+        return low < otherHigh && high > otherLow;
+    }
+    if (delta > 0)
+    {
+        entry = (otherLow - high) / delta;
+        exit = (otherHigh - low) / delta;
+    }
+    else
+    {
+        entry = (otherHigh - low) / delta;
+        exit = (otherLow - high) / delta;
+    }
+    return true;
+}
+}
+
 Hitbox::Hitbox(sf::Vector2f size, sf::Vector2f upperLeftOffset) :
     mSize(size),
     mUpperLeftOffset(upperLeftOffset),
@@ -36,6 +74,47 @@ bool Hitbox::collidesWith(const Hitbox& other) const
             thisTop < otherBottom && thisBottom > otherTop);
 }
 
+bool Hitbox::sweepInto(const Hitbox& other,
+                       const sf::Vector2f& delta,
+                       float& timeOfImpact,
+                       EntitySide& side) const
+{
+    if (!mIsValid || !other.mIsValid)
+        return false;
+
+    float entryX, exitX, entryY, exitY;
+    if (!sweepAxis(getLeft(),
+                   getRight(),
+                   other.getLeft(),
+                   other.getRight(),
+                   delta.x,
+                   entryX,
+                   exitX) ||
+        !sweepAxis(getTop(),
+                   getBottom(),
+                   other.getTop(),
+                   other.getBottom(),
+                   delta.y,
+                   entryY,
+                   exitY))
+    {
+        return false;
+    }
+
+    // Touching edges do not collide, as in collidesWith()
+    const auto entry = std::max(entryX, entryY);
+    const auto exit = std::min(exitX, exitY);
+    if (entry >= exit || entry < 0 || entry > 1)
+        return false;
+
+    timeOfImpact = entry;
+    if (entryX > entryY)
+        side = delta.x > 0 ? EntitySide::RIGHT : EntitySide::LEFT;
+    else
+        side = delta.y > 0 ? EntitySide::BOTTOM : EntitySide::TOP;
+    return true;
+}
+
 void Hitbox::invalidate()
 {
     mIsValid = false;
@@ -66,10 +145,10 @@ float Hitbox::getRight() const
     return getLeft() + mSize.x;
 }
 
-void Hitbox::draw(sf::RenderWindow& window) const
+void Hitbox::draw(sf::RenderTarget& target) const
 {
     sf::RectangleShape rectangle(sf::Vector2f(mSize.x, mSize.y));
     rectangle.setFillColor(sf::Color(150, 50, 250));
     rectangle.setPosition(getLeft(), getTop());
-    window.draw(rectangle);
+    target.draw(rectangle);
 }
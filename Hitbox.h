@@ -40,7 +40,18 @@ public:
 
     [[nodiscard]] bool collidesWith(const Hitbox& other) const;
 
-    void draw(sf::RenderWindow& window) const;
+    /*
+     * Move this hitbox by delta against the stationary other hitbox. If they
+     * start apart and touch along the way, return true with the fraction
+     * of delta covered before touching and the side of this hitbox that
+     * touches first.
+     */
+    [[nodiscard]] bool sweepInto(const Hitbox& other,
+                                 const sf::Vector2f& delta,
+                                 float& timeOfImpact,
+                                 EntitySide& side) const;
+
+    void draw(sf::RenderTarget& target) const;
 
     sf::Vector2f mSize;
     sf::Vector2f mUpperLeftOffset;
@@ -95,7 +95,8 @@ std::vector<KeyboardInput> generateInputs(
     return result;
 }
 
-KeyboardInput nextInput(std::vector<KeyboardInput> keyboardInputs, size_t idx)
+KeyboardInput nextInput(const std::vector<KeyboardInput>& keyboardInputs,
+                        size_t idx)
 {
     return idx < keyboardInputs.size() ? keyboardInputs[idx] : KeyboardInput{};
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "InputQueue.h"
+
+#include <stdexcept>
+
+namespace
+{
+int64_t microsecondsBetween(InputQueue::Clock::time_point start,
+                            InputQueue::Clock::time_point end)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count();
+}
+}
+
+void InputQueue::push(sf::Keyboard::Key key, bool pressed)
+{
+    push(KeyEvent{key, pressed, Clock::now()});
+}
+
+void InputQueue::push(const KeyEvent& event)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.push_back(event);
+}
+
+InputQueue::Latched InputQueue::latch(KeyboardInput& input)
+{
+    mLatching.clear();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::swap(mPending, mLatching);
+    }
+
+    Latched latched{mLatching.size(), {}};
+    for (const auto& event : mLatching)
+        input.setKey(event.key, event.pressed);
+    if (!mLatching.empty())
+        latched.oldestEvent = mLatching.front().time;
+    return latched;
+}
+
+LatencyLog::LatencyLog(const std::string& path) :
+    mOutput(path),
+    mNumFrames(0)
+{
+    if (!mOutput)
+        throw std::runtime_error("Unable to open latency log " + path);
+    mOutput << "frame,events,input_to_display_us,latch_to_display_us\n";
+}
+
+void LatencyLog::record(const InputQueue::Latched& latched,
+                        InputQueue::Clock::time_point latchTime,
+                        InputQueue::Clock::time_point displayTime)
+{
+    mOutput << mNumFrames++ << ',' << latched.numEvents << ',';
+    if (latched.numEvents > 0)
+        mOutput << microsecondsBetween(latched.oldestEvent, displayTime);
+    mOutput << ',' << microsecondsBetween(latchTime, displayTime) << '\n';
+}
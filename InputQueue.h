@@ -0,0 +1,75 @@
+#ifndef SUPERMARIOBROS_INPUTQUEUE_H
+#define SUPERMARIOBROS_INPUTQUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Input.h"
+
+/*
+ * Key events handed from the thread that owns the window to the thread that
+ * runs the game. Each event is stamped when it is pushed, and latch() applies
+ * everything pending to a KeyboardInput right before the frame that uses it,
+ * so a key pressed while the game waits for its next frame still makes that
+ * frame.
+ */
+class InputQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct KeyEvent
+    {
+        sf::Keyboard::Key key;
+        bool pressed;
+        Clock::time_point time;
+    };
+
+    // What one latch() picked up
+    struct Latched
+    {
+        size_t numEvents;
+        // When the oldest of them arrived; meaningless without events
+        Clock::time_point oldestEvent;
+    };
+
+    // Stamped with the current time
+    void push(sf::Keyboard::Key key, bool pressed);
+
+    void push(const KeyEvent& event);
+
+    // Apply the pending events to input, in the order they arrived
+    Latched latch(KeyboardInput& input);
+
+private:
+    std::mutex mMutex;
+    std::vector<KeyEvent> mPending;
+    // Swapped with mPending, so neither side allocates once warmed up
+    std::vector<KeyEvent> mLatching;
+};
+
+/*
+ * One CSV line per frame: the frame number, how many key events were
+ * latched for it, the microseconds from the oldest of them arriving to the
+ * frame being on screen (blank without events), and the microseconds from
+ * the latch to the frame being on screen.
+ */
+class LatencyLog
+{
+public:
+    explicit LatencyLog(const std::string& path);
+
+    void record(const InputQueue::Latched& latched,
+                InputQueue::Clock::time_point latchTime,
+                InputQueue::Clock::time_point displayTime);
+
+private:
+    std::ofstream mOutput;
+    uint64_t mNumFrames;
+};
+
+#endif  // SUPERMARIOBROS_INPUTQUEUE_H
@@ -0,0 +1,198 @@
+#include "InputTape.h"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+const char INPUT_TAPE_MAGIC[4] = {'S', 'M', 'B', 'I'};
+const uint16_t INPUT_TAPE_VERSION = 1;
+
+// Order of the buttons in the packed representation
+KeyboardInputState KeyboardInput::*const BUTTONS[] = {&KeyboardInput::A,
+                                                      &KeyboardInput::B,
+                                                      &KeyboardInput::up,
+                                                      &KeyboardInput::down,
+                                                      &KeyboardInput::left,
+                                                      &KeyboardInput::right,
+                                                      &KeyboardInput::select,
+                                                      &KeyboardInput::start};
+
+void writeLE16(std::ofstream& output, uint16_t value)
+{
+    output.put(static_cast<char>(value & 0xff));
+    output.put(static_cast<char>((value >> 8) & 0xff));
+}
+
+void writeVarint(std::ofstream& output, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        output.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    output.put(static_cast<char>(value));
+}
+
+class TapeReader
+{
+public:
+    explicit TapeReader(const std::vector<unsigned char>& bytes) :
+        mBytes(bytes),
+        mPosition(0)
+    {
+    }
+
+    bool atEnd() const
+    {
+        return mPosition == mBytes.size();
+    }
+
+    unsigned char readByte()
+    {
+        if (atEnd())
+            throw std::runtime_error("Truncated input tape");
+        return mBytes[mPosition++];
+    }
+
+    uint16_t readLE16()
+    {
+        const uint16_t low = readByte();
+        const uint16_t high = readByte();
+        return low | (high << 8);
+    }
+
+    uint32_t readVarint()
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            const auto byte = readByte();
+            result |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return result;
+        }
+        throw std::runtime_error("Malformed run length in input tape");
+    }
+
+private:
+    const std::vector<unsigned char>& mBytes;
+    size_t mPosition;
+};
+}
+
+uint16_t packInput(const KeyboardInput& input)
+{
+    uint16_t packed = 0;
+    for (size_t ii = 0; ii < std::size(BUTTONS); ++ii)
+    {
+        const auto& state = input.*BUTTONS[ii];
+        packed |= static_cast<uint16_t>(state.keyIsDown) << (2 * ii);
+        packed |= static_cast<uint16_t>(state.keyWasDown) << (2 * ii + 1);
+    }
+    return packed;
+}
+
+KeyboardInput unpackInput(uint16_t packed)
+{
+    KeyboardInput input = {};
+    for (size_t ii = 0; ii < std::size(BUTTONS); ++ii)
+    {
+        auto& state = input.*BUTTONS[ii];
+        state.keyIsDown = (packed >> (2 * ii)) & 1;
+        state.keyWasDown = (packed >> (2 * ii + 1)) & 1;
+    }
+    return input;
+}
+
+InputRecorder::InputRecorder(const std::string& path) :
+    mOutput(path, std::ios::binary),
+    mRunValue(0),
+    mRunLength(0)
+{
+    if (!mOutput)
+        throw std::runtime_error("Unable to open input tape " + path);
+    mOutput.write(INPUT_TAPE_MAGIC, sizeof(INPUT_TAPE_MAGIC));
+    writeLE16(mOutput, INPUT_TAPE_VERSION);
+}
+
+InputRecorder::~InputRecorder()
+{
+    flush();
+}
+
+void InputRecorder::record(const KeyboardInput& input)
+{
+    const auto packed = packInput(input);
+    if (mRunLength > 0 && packed != mRunValue)
+        flush();
+    mRunValue = packed;
+    ++mRunLength;
+}
+
+void InputRecorder::flush()
+{
+    if (mRunLength == 0)
+        return;
+    writeVarint(mOutput, mRunLength);
+    writeLE16(mOutput, mRunValue);
+    mOutput.flush();
+    mRunLength = 0;
+}
+
+InputTape InputTape::load(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+        throw std::runtime_error("Unable to open input tape " + path);
+    const std::vector<unsigned char> bytes(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>());
+
+    TapeReader reader(bytes);
+    for (const auto expected : INPUT_TAPE_MAGIC)
+    {
+        if (reader.atEnd() || reader.readByte() != expected)
+            throw std::runtime_error(path + " is not an input tape");
+    }
+    if (reader.readLE16() != INPUT_TAPE_VERSION)
+        throw std::runtime_error("Unsupported input tape version");
+
+    InputTape tape;
+    while (!reader.atEnd())
+    {
+        const auto length = reader.readVarint();
+        const auto value = reader.readLE16();
+        tape.mRuns.push_back(Run{value, length});
+    }
+    return tape;
+}
+
+bool InputTape::next(KeyboardInput& input)
+{
+    while (mRunIndex < mRuns.size() && mFrameInRun == mRuns[mRunIndex].length)
+    {
+        ++mRunIndex;
+        mFrameInRun = 0;
+    }
+    if (mRunIndex == mRuns.size())
+        return false;
+
+    input = unpackInput(mRuns[mRunIndex].value);
+    ++mFrameInRun;
+    return true;
+}
+
+void InputTape::rewind()
+{
+    mRunIndex = 0;
+    mFrameInRun = 0;
+}
+
+size_t InputTape::getNumFrames() const
+{
+    size_t result = 0;
+    for (const auto& run : mRuns)
+        result += run.length;
+    return result;
+}
@@ -0,0 +1,68 @@
+#ifndef SUPERMARIOBROS_INPUTTAPE_H
+#define SUPERMARIOBROS_INPUTTAPE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Input.h"
+
+/*
+ * Input tapes hold one KeyboardInput per frame, bit-packed into 16 bits
+ * (keyIsDown and keyWasDown for each of the eight buttons) and run-length
+ * encoded. A tape is the magic "SMBI", a little-endian uint16 version and
+ * then a sequence of runs, each a LEB128 frame count followed by the
+ * little-endian packed input.
+ */
+
+uint16_t packInput(const KeyboardInput& input);
+KeyboardInput unpackInput(uint16_t packed);
+
+class InputRecorder
+{
+public:
+    explicit InputRecorder(const std::string& path);
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    void record(const KeyboardInput& input);
+
+    // Write out the pending run. Called on destruction.
+    void flush();
+
+private:
+    std::ofstream mOutput;
+    uint16_t mRunValue;
+    uint32_t mRunLength;
+};
+
+class InputTape
+{
+public:
+    static InputTape load(const std::string& path);
+
+    // Returns false once the tape has run out
+    bool next(KeyboardInput& input);
+
+    void rewind();
+
+    [[nodiscard]] size_t getNumFrames() const;
+
+private:
+    struct Run
+    {
+        uint16_t value;
+        uint32_t length;
+    };
+
+    InputTape() = default;
+
+    std::vector<Run> mRuns;
+    size_t mRunIndex = 0;
+    uint32_t mFrameInRun = 0;
+};
+
+#endif  // SUPERMARIOBROS_INPUTTAPE_H
@@ -0,0 +1,189 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "SimulationContext.h"
+
+namespace
+{
+size_t workerThreadsFromEnvironment()
+{
+    const auto numCores =
+            std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const char* value = std::getenv("WORKER_THREADS");
+    if (value == nullptr)
+        return numCores - 1;
+    // More threads than this only fight over the cores
+    const auto maxWorkers = 4 * numCores;
+    char* end = nullptr;
+    const long numWorkers = std::strtol(value, &end, 10);
+    if (end == value || *end != '\0' || numWorkers < 0)
+        throw std::runtime_error("WORKER_THREADS must be a number from 0 to " +
+                                 std::to_string(maxWorkers));
+    return std::min(static_cast<size_t>(numWorkers), maxWorkers);
+}
+}
+
+JobSystem::JobSystem(size_t numWorkers) :
+    mStopping(false),
+    mQueuedJobs(0),
+    mUnfinishedJobs(0),
+    mRunning(false)
+{
+    for (size_t ii = 0; ii <= numWorkers; ++ii)
+        mQueues.push_back(std::make_unique<WorkQueue>());
+    for (size_t ii = 1; ii <= numWorkers; ++ii)
+        mWorkers.emplace_back([this, ii] { workerLoop(ii); });
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    for (auto& worker : mWorkers)
+        worker.join();
+}
+
+size_t JobSystem::getNumWorkers() const
+{
+    return mWorkers.size();
+}
+
+size_t JobSystem::countChunks(size_t count, size_t grainSize)
+{
+    if (grainSize == 0)
+        throw std::runtime_error("Grain size must be at least 1");
+    return (count + grainSize - 1) / grainSize;
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const Task& task)
+{
+    const auto numChunks = countChunks(count, grainSize);
+    if (mWorkers.empty() || numChunks <= 1)
+    {
+        for (size_t chunk = 0; chunk < numChunks; ++chunk)
+            task(chunk * grainSize,
+                 std::min(count, (chunk + 1) * grainSize),
+                 chunk);
+        return;
+    }
+
+    if (mRunning.exchange(true))
+        throw std::runtime_error("JobSystem::parallelFor is not reentrant");
+
+    mUnfinishedJobs = numChunks;
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        for (size_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            auto& queue = *mQueues[chunk % mQueues.size()];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.jobs.push_back(Job{&task,
+                                     chunk * grainSize,
+                                     std::min(count, (chunk + 1) * grainSize),
+                                     chunk});
+        }
+        mQueuedJobs += numChunks;
+    }
+    mWake.notify_all();
+
+    Job job;
+    while (popOrSteal(0, job))
+        runJob(job);
+
+    {
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mDone.wait(lock, [this] { return mUnfinishedJobs == 0; });
+    }
+    mRunning = false;
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mErrorMutex);
+        std::swap(error, mError);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+bool JobSystem::popOrSteal(size_t queue, Job& job)
+{
+    {
+        auto& own = *mQueues[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+            --mQueuedJobs;
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < mQueues.size(); ++offset)
+    {
+        auto& victim = *mQueues[(queue + offset) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            --mQueuedJobs;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::runJob(const Job& job)
+{
+    try
+    {
+        (*job.task)(job.begin, job.end, job.chunk);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mErrorMutex);
+        if (!mError)
+            mError = std::current_exception();
+    }
+
+    if (--mUnfinishedJobs == 0)
+    {
+        // Taking the lock makes sure the caller is either not yet waiting or
+        // already asleep, so the notification cannot be missed
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mDone.notify_all();
+    }
+}
+
+void JobSystem::workerLoop(size_t queue)
+{
+    while (true)
+    {
+        Job job;
+        if (popOrSteal(queue, job))
+        {
+            runJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWake.wait(lock, [this] { return mStopping || mQueuedJobs > 0; });
+        if (mStopping)
+            return;
+    }
+}
+
+JobSystem& getJobSystem()
+{
+    if (const auto* context = getSimulationContext())
+        return *context->jobSystem;
+    static JobSystem jobSystem(workerThreadsFromEnvironment());
+    return jobSystem;
+}
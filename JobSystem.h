@@ -0,0 +1,99 @@
+#ifndef SUPERMARIOBROS_JOBSYSTEM_H
+#define SUPERMARIOBROS_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing thread pool for splitting one phase of a frame across
+ * cores. parallelFor() cuts a range into chunks and deals them out to one
+ * queue per thread; each thread works through its own queue from the back
+ * and, once that is empty, steals from the front of the others. The
+ * calling thread works too, and returns once every chunk is done.
+ *
+ * Chunks are numbered in range order, and the same range and grain size
+ * always give the same chunks, whichever thread runs them. Work that has
+ * to come out in a fixed order (events, say) should be keyed by chunk.
+ *
+ * parallelFor() is not reentrant: a task must not call it again.
+ */
+class JobSystem
+{
+public:
+    // Runs the items [begin, end), which make up the given chunk
+    using Task = std::function<void(size_t begin, size_t end, size_t chunk)>;
+
+    // With no workers every chunk runs in order on the calling thread, so
+    // any number of threads can share such a pool
+    explicit JobSystem(size_t numWorkers);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    [[nodiscard]] size_t getNumWorkers() const;
+
+    [[nodiscard]] static size_t countChunks(size_t count, size_t grainSize);
+
+    /*
+     * Run task over [0, count) in chunks of grainSize items. A range of a
+     * single chunk runs on the calling thread without waking anyone. If a
+     * chunk throws, the first exception is rethrown here once all chunks
+     * have finished.
+     */
+    void parallelFor(size_t count, size_t grainSize, const Task& task);
+
+private:
+    struct Job
+    {
+        const Task* task;
+        size_t begin;
+        size_t end;
+        size_t chunk;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    // Queue 0 belongs to the thread calling parallelFor()
+    bool popOrSteal(size_t queue, Job& job);
+    void runJob(const Job& job);
+    void workerLoop(size_t queue);
+
+    std::vector<std::unique_ptr<WorkQueue>> mQueues;
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mWakeMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    bool mStopping;
+
+    // Jobs sitting in any queue, and jobs of this parallelFor not finished
+    std::atomic<size_t> mQueuedJobs;
+    std::atomic<size_t> mUnfinishedJobs;
+    std::atomic<bool> mRunning;
+
+    std::mutex mErrorMutex;
+    std::exception_ptr mError;
+};
+
+/*
+ * The pool the Level uses. The WORKER_THREADS environment variable sets how
+ * many threads it starts besides the main one, at most four per core; by
+ * default it uses every core. Inside a ScopedSimulationContext it is the
+ * context's instead.
+ */
+JobSystem& getJobSystem();
+
+#endif  // SUPERMARIOBROS_JOBSYSTEM_H
@@ -4,27 +4,200 @@
 #include <entities/InvisibleWall.h>
 #include <entities/Items.h>
 #include <entities/Fireball.h>
+#include <entities/Goomba.h>
+#include <entities/Ground.h>
+#include <entities/Pipe.h>
+#include <LevelStreamer.h>
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <limits>
 
-#include "Event.h"
+#include "EventBus.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #include "SpriteMaker.h"
 #include "Text.h"
 #include "Timer.h"
 
 bool debug = false;
 
+const float Level::DEFAULT_ACTIVITY_MARGIN = 4 * GRIDBOX_SIZE;
+const uint8_t Level::EMPTY_CELL = 0;
+
+namespace
+{
+// Active entities per job when a phase is split across threads. A whole
+// number of lane blocks, so no two jobs write the same block.
+const size_t ENTITY_GRAIN_SIZE = 256;
+static_assert(ENTITY_GRAIN_SIZE % BoundsLanes::LANES == 0,
+              "Jobs must not share a block of bounds lanes");
+
+// Below this many active entities, testing every pair is quicker than
+// building the broad phase, or even than keeping bounds lanes
+const size_t MIN_BROAD_PHASE_ENTITIES = 64;
+
+bool usesBroadPhase(size_t numActive)
+{
+    return numActive >= MIN_BROAD_PHASE_ENTITIES;
+}
+
+// Broad phase pairs per job when detecting collisions
+const size_t PAIR_GRAIN_SIZE = 1024;
+
+// In place of an entity index, for an entity that passed through nothing
+const size_t NO_CONTACT = std::numeric_limits<size_t>::max();
+
+/*
+ * Call visit(index), in increasing order from first, for every entity whose
+ * bounds in lanes touch getBounds(), a block of lanes at a time. visit
+ * returns whether there was a collision; the response may have moved the
+ * entities, so the rest of the block is then tested again.
+ */
+template <typename GetBounds, typename Visit>
+void forEachCandidate(const BoundsLanes& lanes,
+                      size_t first,
+                      GetBounds getBounds,
+                      Visit visit)
+{
+    const auto numLanes = BoundsLanes::LANES;
+    for (auto block = first / numLanes; block < lanes.getNumBlocks(); ++block)
+    {
+        auto mask = lanes.overlapMask(block, getBounds());
+        for (auto lane = first > block * numLanes ? first % numLanes : 0;
+             lane < numLanes && (mask >> lane) != 0;
+             ++lane)
+        {
+            if (((mask >> lane) & 1) != 0 && visit(block * numLanes + lane))
+                mask = lanes.overlapMask(block, getBounds());
+        }
+    }
+}
+
+InvisibleWall& appendInvisibleWall(
+        std::vector<std::unique_ptr<Entity>>& entities, const sf::View& camera)
+{
+    // The wall is never drawn, so it doesn't need a real texture
+    static const sf::Texture noTexture;
+    const auto cameraLeft = camera.getCenter().x - camera.getSize().x / 2;
+    auto wall = std::make_unique<InvisibleWall>(
+            noTexture, sf::Vector2f(cameraLeft - 16, -500));
+    auto& result = *wall;
+    entities.push_back(std::move(wall));
+    return result;
+}
+
+// Construct an entity of the saved kind. restoreState() then overwrites
+// everything the constructor arguments would have set.
+std::unique_ptr<Entity> rebuildEntity(const EntityState& state)
+{
+    const auto& sprites = *getSpriteMaker();
+    const sf::Vector2f position;
+    switch (state.kind)
+    {
+    case EntityKind::GOOMBA:
+        return std::make_unique<Goomba>(sprites.enemyTexture, position);
+    case EntityKind::PIPE:
+        return std::make_unique<Pipe>(sprites.inanimateObjectTexture,
+                                      position);
+    case EntityKind::GROUND:
+        return std::make_unique<Ground>(sprites.inanimateObjectTexture,
+                                        position);
+    case EntityKind::BREAKABLE_BLOCK:
+        return std::make_unique<BreakableBlock>(
+                sprites.inanimateObjectTexture, position);
+    case EntityKind::ITEM_BLOCK:
+        return std::make_unique<ItemBlock>(sprites.inanimateObjectTexture,
+                                           position);
+    case EntityKind::BLOCK_SHARD:
+        return std::make_unique<BlockShard>(
+                sprites.blockTexture, position, position, position);
+    case EntityKind::MUSHROOM:
+        return std::make_unique<Mushroom>(
+                sprites.itemAndObjectTexture, position, state.anchor);
+    case EntityKind::FIREFLOWER:
+        return std::make_unique<Fireflower>(
+                sprites.itemAndObjectTexture, position, state.anchor);
+    case EntityKind::FIREBALL:
+        return std::make_unique<Fireball>(
+                sprites.itemAndObjectTexture, position, 1);
+    case EntityKind::MARIO:
+    case EntityKind::INVISIBLE_WALL:
+        // Both live as long as the Level
+        break;
+    }
+    throw std::runtime_error("Cannot rebuild entity from save state");
+}
+}
+
 Level::Level(std::unique_ptr<Mario> mario,
              std::vector<std::unique_ptr<Entity>>&& entities,
-             sf::RenderWindow& window,
+             const sf::View& camera,
              InvisibleWall& wall) :
     mMario(std::move(mario)),
     mEntities(std::move(entities)),
-    mWindow(window),
-    mWall(wall)
+    mActivityMargin(DEFAULT_ACTIVITY_MARGIN),
+    mCamera(camera),
+    mWall(wall),
+    mEventBus(getEventBus())
 {
     mPoints = std::make_shared<Points>(0, sf::Vector2f{10, 18});
     addHUDOverlay();
+    subscribeToEvents();
+    collectActiveEntities();
+}
+
+Level::Level(std::unique_ptr<Mario> mario,
+             std::vector<std::unique_ptr<Entity>>&& entities,
+             const sf::View& camera) :
+    Level(std::move(mario),
+          std::move(entities),
+          camera,
+          appendInvisibleWall(entities, camera))
+{
+}
+
+sf::View Level::defaultCamera()
+{
+    return sf::View(sf::Vector2f(100, 100), sf::Vector2f(200, 200));
+}
+
+Level::~Level()
+{
+    mEventBus.unsubscribe(this);
+}
+
+void Level::subscribeToEvents()
+{
+    auto& bus = mEventBus;
+    bus.subscribe<Event::PointsEarned>(
+            [this](const std::vector<Event::PointsEarned>& events)
+            { onPointsEarned(events); },
+            this);
+    bus.subscribe<Event::ItemSpawned>(
+            [this](const std::vector<Event::ItemSpawned>& events)
+            { onItemsSpawned(events); },
+            this);
+    bus.subscribe<Event::BlockShattered>(
+            [this](const std::vector<Event::BlockShattered>& events)
+            { onBlocksShattered(events); },
+            this);
+    bus.subscribe<Event::AnimationCompleted>(
+            [this](const std::vector<Event::AnimationCompleted>& events)
+            { onAnimationsCompleted(events); },
+            this);
+    bus.subscribe<Event::FireballSpawned>(
+            [this](const std::vector<Event::FireballSpawned>& events)
+            { onFireballsSpawned(events); },
+            this);
+}
+
+void Level::setStreamer(std::unique_ptr<LevelStreamer> streamer)
+{
+    mStreamer = std::move(streamer);
+    streamChunks(mCamera);
+    collectActiveEntities();
 }
 
 void Level::addHUDOverlay()
@@ -39,41 +212,492 @@ bool Level::physicsAreOn() const
     return !mMario->isTransitioning();
 }
 
+void Level::setActivityMargin(float margin)
+{
+    mActivityMargin = margin;
+}
+
+void Level::collidePairs(JobSystem& jobSystem)
+{
+    const auto numActive = mActiveEntities.size();
+    // Taken once, after Mario's pass. An entity that a response below wakes
+    // keeps counting as asleep until the next frame, so its pairs with other
+    // sleepers wait a frame. Its projected hitboxes don't move until then
+    // anyway, and the broad phase only bins the entities awake here.
+    mAwake.resize(numActive);
+    mAwakeIndices.clear();
+    for (size_t ii = 0; ii < numActive; ++ii)
+    {
+        mAwake[ii] = !mActiveEntities[ii]->isAsleep();
+        if (mAwake[ii])
+            mAwakeIndices.push_back(ii);
+    }
+    if (mAwakeIndices.empty())
+        return;
+
+    // Entities pushed by a response outside the bounds the broad phase saw
+    // are tested against every later entity, as if there were no broad
+    // phase, so the pairs are still tested in the same order and with the
+    // same outcome
+    const auto useBroadPhase = usesBroadPhase(numActive);
+    mEscaped.assign(numActive, false);
+    mEscapedIndices.clear();
+    mTouched.assign(numActive, false);
+    mFirstContact.assign(numActive, NO_CONTACT);
+    const auto resolve =
+            [this, useBroadPhase](
+                    size_t ii, size_t jj, const CollisionRecord& record)
+    {
+        auto* hitboxes = &mProjectedHitboxes[ii];
+        auto* otherHitboxes = &mProjectedHitboxes[jj];
+        if (record.entity != mActiveEntities[ii])
+            std::swap(hitboxes, otherHitboxes);
+        resolveCollision(record, *hitboxes, *otherHitboxes);
+
+        for (const auto moved : {ii, jj})
+        {
+            mTouched[moved] = true;
+            if (!useBroadPhase)
+                continue;
+            const auto bounds =
+                    BroadPhase::boundsOf(mProjectedHitboxes[moved]);
+            mBoundsLanes.set(moved, bounds);
+            if (mEscaped[moved] || mBroadPhase.isInsideBounds(moved, bounds))
+                continue;
+            mEscaped[moved] = true;
+            mEscapedIndices.insert(std::upper_bound(mEscapedIndices.begin(),
+                                                    mEscapedIndices.end(),
+                                                    moved),
+                                   moved);
+        }
+    };
+    // Whether a collision is one its moving entity responds to. One that
+    // passed clean through something only stops at the first thing it met.
+    const auto isFirstContact =
+            [this](size_t ii, size_t jj, const CollisionRecord& record)
+    {
+        if (record.entity != mActiveEntities[ii])
+            std::swap(ii, jj);
+        return mFirstContact[ii] == NO_CONTACT || mFirstContact[ii] == jj;
+    };
+    // Returns whether the two collided
+    const auto collide = [this, &resolve, &isFirstContact](size_t ii, size_t jj)
+    {
+        if (!mAwake[ii] && !mAwake[jj])
+            return false;
+        if (!canCollide(mActiveTypes[ii], mActiveTypes[jj]))
+            return false;
+        CollisionRecord record;
+        if (!mActiveEntities[ii]->findCollision(*mActiveEntities[jj],
+                                                mProjectedHitboxes[ii],
+                                                mProjectedHitboxes[jj],
+                                                record) ||
+            !isFirstContact(ii, jj, record))
+            return false;
+        resolve(ii, jj, record);
+        return true;
+    };
+    const auto collideWithRest = [&](size_t ii, size_t firstPartner)
+    {
+        if (mAwake[ii])
+        {
+            forEachCandidate(
+                    mBoundsLanes,
+                    firstPartner,
+                    [this, ii] { return mBoundsLanes.get(ii); },
+                    [&collide, ii](size_t jj) { return collide(ii, jj); });
+            return;
+        }
+        for (auto jj = std::lower_bound(mAwakeIndices.cbegin(),
+                                        mAwakeIndices.cend(),
+                                        firstPartner);
+             jj != mAwakeIndices.cend();
+             ++jj)
+            collide(ii, *jj);
+    };
+
+    // Small levels skip the broad phase and take every pair that could
+    // collide, in the same order
+    if (!useBroadPhase)
+    {
+        mAllPairs.clear();
+        for (size_t ii = 0; ii < numActive; ++ii)
+        {
+            for (auto jj = ii + 1; jj < numActive; ++jj)
+            {
+                if ((mAwake[ii] || mAwake[jj]) &&
+                    canCollide(mActiveTypes[ii], mActiveTypes[jj]))
+                    mAllPairs.emplace_back(ii, jj);
+            }
+        }
+    }
+    const auto& pairs =
+            useBroadPhase
+                    ? mBroadPhase.findPairs(
+                              mBoundsLanes, mActiveTypes, mAwake, numActive,
+                              jobSystem)
+                    : mAllPairs;
+
+    // Detection only reads the two entities, so every pair can be tested
+    // at once against the state the responses start from
+    const auto numChunks = JobSystem::countChunks(pairs.size(), PAIR_GRAIN_SIZE);
+    mChunkCollisions.resize(std::max(mChunkCollisions.size(), numChunks));
+    jobSystem.parallelFor(
+            pairs.size(),
+            PAIR_GRAIN_SIZE,
+            [this, &pairs](size_t begin, size_t end, size_t chunk)
+            {
+                auto& detected = mChunkCollisions[chunk];
+                detected.clear();
+                CollisionRecord record;
+                for (auto index = begin; index < end; ++index)
+                {
+                    const auto [ii, jj] = pairs[index];
+                    if (mActiveEntities[ii]->findCollision(
+                                *mActiveEntities[jj],
+                                mProjectedHitboxes[ii],
+                                mProjectedHitboxes[jj],
+                                record))
+                        detected.push_back({index, record});
+                }
+            });
+    mDetectedCollisions.clear();
+    auto passedThrough = false;
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for (const auto& collision : mChunkCollisions[chunk])
+            passedThrough = passedThrough || collision.record.isSwept;
+        mDetectedCollisions.insert(mDetectedCollisions.end(),
+                                   mChunkCollisions[chunk].begin(),
+                                   mChunkCollisions[chunk].end());
+    }
+    if (passedThrough)
+        findFirstContacts(pairs);
+
+    // Resolve in pair order. A detected collision still holds if neither
+    // entity has been changed by a response since; otherwise the pair is
+    // tested again against where the entities are now.
+    auto detected = mDetectedCollisions.cbegin();
+    const auto collidePair = [&](size_t index)
+    {
+        const auto [ii, jj] = pairs[index];
+        if (mTouched[ii] || mTouched[jj])
+        {
+            collide(ii, jj);
+            return;
+        }
+        while (detected != mDetectedCollisions.cend() && detected->pair < index)
+            ++detected;
+        if (detected != mDetectedCollisions.cend() &&
+            detected->pair == index &&
+            isFirstContact(ii, jj, detected->record))
+            resolve(ii, jj, detected->record);
+    };
+
+    auto pair = pairs.cbegin();
+    for (size_t ii = 0; ii < numActive; ++ii)
+    {
+        // Walk this entity's pairs and the escaped entities after it
+        // together, in increasing order
+        size_t next = ii + 1;
+        while (!mEscaped[ii])
+        {
+            while (pair != pairs.cend() && pair->first == ii &&
+                   pair->second < next)
+                ++pair;
+            const auto escaped = std::lower_bound(
+                    mEscapedIndices.cbegin(), mEscapedIndices.cend(), next);
+            const auto hasPair = pair != pairs.cend() && pair->first == ii;
+            auto jj = hasPair ? pair->second : numActive;
+            if (escaped != mEscapedIndices.cend())
+                jj = std::min(jj, *escaped);
+            if (jj == numActive)
+                break;
+            if (hasPair && pair->second == jj)
+                collidePair(pair - pairs.cbegin());
+            else
+                collide(ii, jj);
+            next = jj + 1;
+        }
+        if (mEscaped[ii])
+            collideWithRest(ii, next);
+
+        while (pair != pairs.cend() && pair->first == ii)
+            ++pair;
+    }
+}
+
+void Level::findFirstContacts(const std::vector<BroadPhase::Pair>& pairs)
+{
+    // Every detected collision by the entity whose movement caused it, and
+    // for each entity in the order it would have met them. The sort is
+    // stable, so ties stay in pair order.
+    mContacts.clear();
+    for (const auto& collision : mDetectedCollisions)
+    {
+        size_t entity = pairs[collision.pair].first;
+        size_t other = pairs[collision.pair].second;
+        if (collision.record.entity != mActiveEntities[entity])
+            std::swap(entity, other);
+        mContacts.push_back({entity,
+                             other,
+                             collision.record.timeOfImpact,
+                             collision.record.isSwept});
+    }
+    std::stable_sort(mContacts.begin(),
+                     mContacts.end(),
+                     [](const Contact& contact, const Contact& other)
+                     {
+                         return contact.entity != other.entity
+                                        ? contact.entity < other.entity
+                                        : contact.timeOfImpact <
+                                                  other.timeOfImpact;
+                     });
+
+    for (auto first = mContacts.cbegin(); first != mContacts.cend();)
+    {
+        auto last = first;
+        auto passedThrough = false;
+        for (; last != mContacts.cend() && last->entity == first->entity;
+             ++last)
+            passedThrough = passedThrough || last->isSwept;
+        if (passedThrough)
+            mFirstContact[first->entity] = first->other;
+        first = last;
+    }
+}
+
+void Level::resolveCollision(const CollisionRecord& record,
+                             ProjectedHitboxes& hitboxes,
+                             ProjectedHitboxes& otherHitboxes)
+{
+    Entity::resolveCollision(record);
+    hitboxes = record.entity->projectHitboxes();
+    otherHitboxes = record.collision.entity->projectHitboxes();
+    mResolvedCollisions.push_back({record.entity->getId(),
+                                   record.collision.entity->getId(),
+                                   record.collision.side});
+}
+
+void Level::collectActiveEntities()
+{
+    const auto halfWidth = mCamera.getSize().x / 2;
+    const auto activeLeft = mCamera.getCenter().x - halfWidth - mActivityMargin;
+    const auto activeRight =
+            mCamera.getCenter().x + halfWidth + mActivityMargin;
+
+    mActiveEntities.clear();
+    for (auto& entity : mEntities)
+    {
+        if (entity->getRight() >= activeLeft && entity->getLeft() <= activeRight)
+            mActiveEntities.push_back(entity.get());
+    }
+}
+
 void Level::executeFrame(const KeyboardInput& input)
 {
-    scroll();
+    PROFILE_SCOPE("executeFrame");
+    {
+        PROFILE_SCOPE("scroll");
+        scroll();
+    }
+
+    mResolvedCollisions.clear();
 
     // Reset mDeltaP
     mMario->mDeltaP.x = 0;
     mMario->mDeltaP.y = 0;
 
+    // Collected even while physics are off, since the streamer may have
+    // unloaded entities and the observation grid reads the list
+    collectActiveEntities();
     if (physicsAreOn())
     {
-        for (auto& entity : mEntities)
+        auto& jobSystem = getJobSystem();
+
         {
-            entity->mDeltaP.x = 0;
-            entity->mDeltaP.y = 0;
-        }
+            PROFILE_SCOPE("integrate");
+            setMarioMovementFromController(input);
+            mMario->updatePosition();
 
-        setMarioMovementFromController(input);
-        mMario->updatePosition();
+            // Each entity only looks at its own state, so they can be moved
+            // in any order and on any thread
+            jobSystem.parallelFor(
+                    mActiveEntities.size(),
+                    ENTITY_GRAIN_SIZE,
+                    [this](size_t begin, size_t end, size_t)
+                    {
+                        for (auto ii = begin; ii < end; ++ii)
+                        {
+                            auto* entity = mActiveEntities[ii];
+                            entity->mDeltaP.x = 0;
+                            entity->mDeltaP.y = 0;
+                            if (entity->isAsleep())
+                                continue;
+                            entity->updatePosition();
+                            if (!entity->isAsleep())
+                                entity->doInternalCalculations();
+                        }
+                    });
+        }
 
-        for (auto& entity : mEntities)
+        // Small levels skip the bounds lanes along with the broad phase
+        const auto useBroadPhase = usesBroadPhase(mActiveEntities.size());
         {
-            entity->updatePosition();
-            entity->doInternalCalculations();
+            PROFILE_SCOPE("project hitboxes");
+            const auto marioHitboxes = mMario->projectHitboxes();
+            mProjectedHitboxes.resize(mActiveEntities.size() + 1,
+                                      marioHitboxes);
+            mProjectedHitboxes.back() = marioHitboxes;
+            mActiveTypes.resize(mActiveEntities.size());
+            if (useBroadPhase)
+                mBoundsLanes.resize(mActiveEntities.size());
+            jobSystem.parallelFor(
+                    mActiveEntities.size(),
+                    ENTITY_GRAIN_SIZE,
+                    [this, useBroadPhase](size_t begin, size_t end, size_t)
+                    {
+                        for (auto ii = begin; ii < end; ++ii)
+                        {
+                            mProjectedHitboxes[ii] =
+                                    mActiveEntities[ii]->projectHitboxes();
+                            mActiveTypes[ii] = mActiveEntities[ii]->getType();
+                            if (!useBroadPhase)
+                                continue;
+                            mBoundsLanes.set(ii,
+                                             BroadPhase::boundsOf(
+                                                     mProjectedHitboxes[ii]));
+                        }
+                    });
         }
+        {
+            PROFILE_SCOPE("Mario collision");
+            auto& marioHitboxes = mProjectedHitboxes.back();
+            auto marioBounds = BroadPhase::boundsOf(marioHitboxes);
+            const auto forEachMarioCandidate = [&](auto visit)
+            {
+                if (useBroadPhase)
+                    forEachCandidate(mBoundsLanes,
+                                     0,
+                                     [&marioBounds] { return marioBounds; },
+                                     visit);
+                else
+                    for (size_t ii = 0; ii < mActiveEntities.size(); ++ii)
+                        visit(ii);
+            };
+            const auto findMarioCollision = [&](size_t ii,
+                                                CollisionRecord& record)
+            {
+                // Mario's type changes as he powers up, so it's not cached
+                return canCollide(mMario->getType(), mActiveTypes[ii]) &&
+                       mMario->findCollision(*mActiveEntities[ii],
+                                             marioHitboxes,
+                                             mProjectedHitboxes[ii],
+                                             record);
+            };
+
+            // Everything Mario runs into is found before any of it is
+            // responded to, so that if he passed clean through something he
+            // only stops at whatever he met first
+            mMarioCollisions.clear();
+            forEachMarioCandidate(
+                    [&](size_t ii)
+                    {
+                        CollisionRecord record;
+                        if (findMarioCollision(ii, record))
+                            mMarioCollisions.push_back({ii, record});
+                        return false;
+                    });
+            const DetectedCollision* earliest = nullptr;
+            auto passedThrough = false;
+            for (const auto& collision : mMarioCollisions)
+            {
+                if (collision.record.entity != mMario.get())
+                    continue;
+                passedThrough = passedThrough || collision.record.isSwept;
+                if (earliest == nullptr ||
+                    collision.record.timeOfImpact <
+                            earliest->record.timeOfImpact)
+                    earliest = &collision;
+            }
+            const auto firstContact =
+                    passedThrough ? earliest->pair : NO_CONTACT;
+
+            // A collision found above holds until a response changes Mario;
+            // after that each entity is tested against where he is now
+            auto found = mMarioCollisions.cbegin();
+            auto isMarioTouched = false;
+            // Returns whether Mario collided with the entity
+            const auto collideWithMario = [&](size_t ii)
+            {
+                CollisionRecord record;
+                if (isMarioTouched)
+                {
+                    if (!findMarioCollision(ii, record))
+                        return false;
+                }
+                else
+                {
+                    while (found != mMarioCollisions.cend() && found->pair < ii)
+                        ++found;
+                    if (found == mMarioCollisions.cend() || found->pair != ii)
+                        return false;
+                    record = found->record;
+                }
+                if (firstContact != NO_CONTACT && ii != firstContact &&
+                    record.entity == mMario.get())
+                    return false;
 
-        mMario->collideWithEntity(mEntities);
-        for (size_t ii = 0; ii < mEntities.size(); ++ii)
-            for (size_t jj = ii + 1; jj < mEntities.size(); ++jj)
-                mEntities[ii]->collideWithEntity(mEntities[jj]);
+                if (record.entity == mMario.get())
+                    resolveCollision(
+                            record, marioHitboxes, mProjectedHitboxes[ii]);
+                else
+                    resolveCollision(
+                            record, mProjectedHitboxes[ii], marioHitboxes);
+                isMarioTouched = true;
+                if (useBroadPhase)
+                {
+                    marioBounds = BroadPhase::boundsOf(marioHitboxes);
+                    mBoundsLanes.set(
+                            ii, BroadPhase::boundsOf(mProjectedHitboxes[ii]));
+                }
+                return true;
+            };
+            forEachMarioCandidate(collideWithMario);
+        }
+        {
+            PROFILE_SCOPE("pair collision");
+            collidePairs(jobSystem);
+        }
 
-        for (auto& entity : mEntities)
         {
-            entity->updateAnimation();
+            PROFILE_SCOPE("animation");
+            // Animations can raise events, which are staged per chunk and
+            // merged in entity order
+            auto& eventBus = mEventBus;
+            eventBus.setNumStages(std::max(
+                    eventBus.getNumStages(),
+                    JobSystem::countChunks(mActiveEntities.size(),
+                                           ENTITY_GRAIN_SIZE)));
+            jobSystem.parallelFor(mActiveEntities.size(),
+                                  ENTITY_GRAIN_SIZE,
+                                  [this, &eventBus](size_t begin,
+                                                    size_t end,
+                                                    size_t chunk)
+                                  {
+                                      ScopedEventStage stage(eventBus, chunk);
+                                      for (auto ii = begin; ii < end; ++ii)
+                                          mActiveEntities[ii]->updateAnimation();
+                                  });
+            eventBus.mergeStages();
         }
 
+        PROFILE_SCOPE("cleanup");
+        mActiveEntities.erase(std::remove_if(mActiveEntities.begin(),
+                                             mActiveEntities.end(),
+                                             [](Entity* entity)
+                                             { return entity->needsCleanup(); }),
+                              mActiveEntities.end());
         mEntities.erase(std::remove_if(mEntities.begin(),
                                        mEntities.end(),
                                        [](std::unique_ptr<Entity>& entity)
@@ -83,38 +707,16 @@ void Level::executeFrame(const KeyboardInput& input)
 
     mMario->updateAnimation();
 
-    for (const auto& event : getEventQueue())
-    {
-        switch (event.type)
-        {
-        case EventType::POINTS_EARNED:
-            onPointsEarned(event.asPointsEarned());
-            break;
-        case EventType::ITEM_SPAWNED:
-            onItemSpawned(event.asItemSpawned());
-            break;
-        case EventType::BLOCK_SHATTERED:
-            onBlockShattered(event.asBlockShattered());
-            break;
-        case EventType::ANIMATION_COMPLETED:
-            onAnimationCompleted(event.asAnimationCompleted());
-            break;
-        case EventType::FIREBALL_SPAWNED:
-            onFireballSpawned(event.asFireballSpawned());
-            break;
-        }
-    }
-    getEventQueue().clear();
+    PROFILE_SCOPE("event dispatch");
+    mEventBus.dispatch();
 }
 
 void Level::scroll()
 {
-    auto view = mWindow.getView();
-    if (mMario->getLeft() >= view.getCenter().x)
+    if (mMario->getLeft() >= mCamera.getCenter().x)
     {
-        const auto scrollDistance = mMario->getLeft() - view.getCenter().x;
-        view.move(scrollDistance, 0);
-        mWindow.setView(view);
+        const auto scrollDistance = mMario->getLeft() - mCamera.getCenter().x;
+        mCamera.move(scrollDistance, 0);
         mWall.addPositionDelta(scrollDistance, 0);
 
         for (auto& text : mTextElements)
@@ -122,99 +724,249 @@ void Level::scroll()
             text->updatePosition(scrollDistance, 0);
         }
     }
+    streamChunks(mCamera);
 }
 
-void Level::onBlockShattered(const Event::BlockShattered& event)
+void Level::streamChunks(const sf::View& view)
 {
-    const auto left = event.position.x;
-    const auto top = event.position.y;
-    // Spawn block shards after destruction
-    // Upper left
-    mEntities.push_back(
-            std::make_unique<BlockShard>(getSpriteMaker()->blockTexture,
-                                         sf::Vector2f{left, top},
-                                         sf::Vector2f(0, 0),
-                                         sf::Vector2f(-1, -5)));
+    if (!mStreamer)
+        return;
+
+    const auto halfWidth = view.getSize().x / 2;
+    LevelStreamer::unloadBehind(
+            view.getCenter().x - halfWidth, mEntities, &mWall);
+    mStreamer->loadAhead(view.getCenter().x + halfWidth, mEntities);
+}
+
+void Level::saveState(LevelState& state) const
+{
+    mMario->saveState(state.mario);
+    state.entities.resize(mEntities.size());
+    for (size_t ii = 0; ii < mEntities.size(); ++ii)
+        mEntities[ii]->saveState(state.entities[ii]);
+
+    const auto& timer = getTimer();
+    state.numFrames = timer.numFrames;
+    state.timedActions.clear();
+    for (const auto& event : timer.scheduledTimes)
+    {
+        if (event.mAction)
+        {
+            state.timedActions.push_back(
+                    TimedActionState{event.mTime,
+                                     event.mAction,
+                                     event.mTarget->getId(),
+                                     event.mScript,
+                                     static_cast<uint32_t>(event.mStep)});
+        }
+    }
+
+    state.points = mPoints->getPoints();
+    state.cameraCenter = mCamera.getCenter();
+
+    state.hasStreamer = mStreamer != nullptr;
+    if (mStreamer)
+        mStreamer->saveState(state.streamer);
+}
+
+void Level::restoreState(const LevelState& state)
+{
+    const auto wallId = mWall.getId();
+    if (state.mario.id != mMario->getId() ||
+        std::none_of(state.entities.begin(),
+                     state.entities.end(),
+                     [wallId](const EntityState& entity)
+                     { return entity.id == wallId; }))
+    {
+        throw std::runtime_error("Save state belongs to a different level");
+    }
+
+    mMario->restoreState(state.mario);
+
+    using Scratch = std::pair<uint32_t, std::unique_ptr<Entity>>;
+    mRestoreScratch.clear();
+    for (auto& entity : mEntities)
+        mRestoreScratch.emplace_back(entity->getId(), std::move(entity));
+    std::sort(mRestoreScratch.begin(),
+              mRestoreScratch.end(),
+              [](const Scratch& lhs, const Scratch& rhs)
+              { return lhs.first < rhs.first; });
+
+    // Keep the saved order, since collisions are resolved in that order
+    mEntities.clear();
+    for (const auto& entityState : state.entities)
+    {
+        const auto match = std::lower_bound(
+                mRestoreScratch.begin(),
+                mRestoreScratch.end(),
+                entityState.id,
+                [](const Scratch& entity, uint32_t id)
+                { return entity.first < id; });
+        if (match != mRestoreScratch.end() && match->first == entityState.id)
+            mEntities.push_back(std::move(match->second));
+        else
+            mEntities.push_back(rebuildEntity(entityState));
+        mEntities.back()->restoreState(entityState);
+    }
+    // Whatever is left was created after the snapshot
+    mRestoreScratch.clear();
 
-    // Upper right
-    mEntities.push_back(
-            std::make_unique<BlockShard>(getSpriteMaker()->blockTexture,
-                                         sf::Vector2f{left + 8, top},
-                                         sf::Vector2f(8, 0),
-                                         sf::Vector2f(1, -5)));
+    // Rebuilt entities may have scheduled actions of their own
+    auto& timer = getTimer();
+    timer.numFrames = state.numFrames;
+    auto& scheduled = timer.scheduledTimes;
+    scheduled.erase(std::remove_if(scheduled.begin(),
+                                   scheduled.end(),
+                                   [](const ScheduledEvent& event)
+                                   { return event.mAction != nullptr; }),
+                    scheduled.end());
+    for (const auto& action : state.timedActions)
+    {
+        auto* owner = findEntity(action.ownerId);
+        if (!owner)
+            throw std::runtime_error("Timed action without an owner");
+        if (action.script)
+            scheduled.emplace_back(static_cast<size_t>(action.time),
+                                   *action.script,
+                                   action.step,
+                                   *owner);
+        else
+            scheduled.emplace_back(
+                    static_cast<size_t>(action.time), action.action, *owner);
+    }
+
+    mPoints->setPoints(state.points);
+
+    const auto scrollDistance = state.cameraCenter.x - mCamera.getCenter().x;
+    mCamera.setCenter(state.cameraCenter);
+    for (auto& text : mTextElements)
+        text->updatePosition(scrollDistance, 0);
 
-    // Lower right
-    mEntities.push_back(
-            std::make_unique<BlockShard>(getSpriteMaker()->blockTexture,
-                                         sf::Vector2f{left + 8, top + 8},
-                                         sf::Vector2f(8, 8),
-                                         sf::Vector2f(1, -5)));
+    if (mStreamer && state.hasStreamer)
+        mStreamer->restoreState(state.streamer);
+    collectActiveEntities();
+}
 
-    // Lower left
-    mEntities.push_back(
-            std::make_unique<BlockShard>(getSpriteMaker()->blockTexture,
-                                         sf::Vector2f{left, top + 8},
-                                         sf::Vector2f(0, 8),
-                                         sf::Vector2f(-1, -5)));
+Entity* Level::findEntity(uint32_t id) const
+{
+    if (mMario->getId() == id)
+        return mMario.get();
+    for (const auto& entity : mEntities)
+    {
+        if (entity->getId() == id)
+            return entity.get();
+    }
+    return nullptr;
 }
 
-void Level::addEntityToFront(std::unique_ptr<Entity> entity)
+void Level::onBlocksShattered(const std::vector<Event::BlockShattered>& events)
 {
-    mEntities.insert(mEntities.begin(), std::move(entity));
+    // Each block breaks into four shards, one per quarter, flying outwards
+    struct ShardOffset
+    {
+        sf::Vector2f fragmentOffset;
+        sf::Vector2f initialVelocity;
+    };
+    const ShardOffset shards[] = {
+            {{0, 0}, {-1, -5}},  // Upper left
+            {{8, 0}, {1, -5}},   // Upper right
+            {{8, 8}, {1, -5}},   // Lower right
+            {{0, 8}, {-1, -5}},  // Lower left
+    };
+
+    mEntities.reserve(mEntities.size() + events.size() * std::size(shards));
+    for (const auto& event : events)
+    {
+        for (const auto& shard : shards)
+        {
+            mEntities.push_back(std::make_unique<BlockShard>(
+                    getSpriteMaker()->blockTexture,
+                    event.position + shard.fragmentOffset,
+                    shard.fragmentOffset,
+                    shard.initialVelocity));
+            mActiveEntities.push_back(mEntities.back().get());
+        }
+    }
 }
 
-void Level::onPointsEarned(const Event::PointsEarned& event)
+void Level::onPointsEarned(const std::vector<Event::PointsEarned>& events)
 {
-    mPoints->addPoints(event.points);
+    size_t points = 0;
+    for (const auto& event : events)
+        points += event.points;
+    mPoints->addPoints(points);
 }
 
-void Level::onItemSpawned(const Event::ItemSpawned& event)
+void Level::onItemsSpawned(const std::vector<Event::ItemSpawned>& events)
 {
     // Adding to front to ensure that mushroom is drawn before the block
-    // i.e. the block obscures the mushroom from view
-    switch (event.type)
+    // i.e. the block obscures the mushroom from view. The latest item goes
+    // in front, as if each had been added on its own.
+    mSpawnScratch.clear();
+    for (auto event = events.rbegin(); event != events.rend(); ++event)
     {
-    case EntityType::MUSHROOM:
-        addEntityToFront(std::make_unique<Mushroom>(
-                getSpriteMaker()->itemAndObjectTexture,
-                event.position,
-                event.blockTop));
-        break;
-    case EntityType::FIREFLOWER:
-        addEntityToFront(std::make_unique<Fireflower>(
-                getSpriteMaker()->itemAndObjectTexture,
-                event.position,
-                event.blockTop));
-        break;
-    default:
-        throw std::runtime_error("Unhandled entity type");
+        switch (event->type)
+        {
+        case EntityType::MUSHROOM:
+            mSpawnScratch.push_back(std::make_unique<Mushroom>(
+                    getSpriteMaker()->itemAndObjectTexture,
+                    event->position,
+                    event->blockTop));
+            break;
+        case EntityType::FIREFLOWER:
+            mSpawnScratch.push_back(std::make_unique<Fireflower>(
+                    getSpriteMaker()->itemAndObjectTexture,
+                    event->position,
+                    event->blockTop));
+            break;
+        default:
+            throw std::runtime_error("Unhandled entity type");
+        }
     }
+    for (const auto& item : mSpawnScratch)
+        mActiveEntities.push_back(item.get());
+    mEntities.insert(mEntities.begin(),
+                     std::make_move_iterator(mSpawnScratch.begin()),
+                     std::make_move_iterator(mSpawnScratch.end()));
+    mSpawnScratch.clear();
 }
 
-void Level::onFireballSpawned(const Event::FireballSpawned& event)
+void Level::onFireballsSpawned(
+        const std::vector<Event::FireballSpawned>& events)
 {
-    mEntities.push_back(std::make_unique<Fireball>(
-        getSpriteMaker()->itemAndObjectTexture,
-        event.position,
-        event.direction));
+    mEntities.reserve(mEntities.size() + events.size());
+    for (const auto& event : events)
+    {
+        mEntities.push_back(std::make_unique<Fireball>(
+                getSpriteMaker()->itemAndObjectTexture,
+                event.position,
+                event.direction));
+        mActiveEntities.push_back(mEntities.back().get());
+    }
 }
 
-void Level::onAnimationCompleted(const Event::AnimationCompleted& event)
+void Level::onAnimationsCompleted(
+        const std::vector<Event::AnimationCompleted>& events)
 {
-    if (event.animationType == "shrinkingAnimation")
+    for (const auto& event : events)
     {
-        mMario->changeToSmallDimensions();
+        if (event.animationType == "shrinkingAnimation")
+        {
+            mMario->changeToSmallDimensions();
+        }
     }
 }
 
-void Level::drawFrame(sf::RenderWindow& window)
+void Level::drawFrame(sf::RenderTarget& target)
 {
-    window.clear(sf::Color(0, 0, 255, 255));
+    PROFILE_SCOPE("drawFrame");
+    target.setView(mCamera);
+    target.clear(sf::Color(0, 0, 255, 255));
     for (auto& entity : mEntities)
-        entity->draw(window);
-    mMario->draw(window);
+        entity->draw(target);
+    mMario->draw(target);
     for (auto& text : mTextElements)
-        text->draw(window);
+        text->draw(target);
 }
 
 void Level::setMarioMovementFromController(const KeyboardInput& currentInput)
@@ -330,14 +1082,70 @@ const Mario& Level::getMario() const
     return *mMario;
 }
 
-std::vector<Event> gEventQueue;
+void Level::writeObservation(uint8_t* cells,
+                             size_t width,
+                             size_t height,
+                             float cellSize) const
+{
+    PROFILE_SCOPE("observation");
+    std::fill(cells, cells + width * height, EMPTY_CELL);
+    if (width == 0 || height == 0)
+        return;
+
+    const auto left = mCamera.getCenter().x - width * cellSize / 2;
+    const auto top = mCamera.getCenter().y - height * cellSize / 2;
+    // The cells an edge covers, clamped to the grid; first > last if none
+    const auto cellRange = [cellSize](float from, float to, size_t numCells)
+    {
+        const auto first = std::max(0.f, std::floor(from / cellSize));
+        const auto last = std::min(static_cast<float>(numCells) - 1,
+                                   std::ceil(to / cellSize) - 1);
+        return std::make_pair(static_cast<int64_t>(first),
+                              static_cast<int64_t>(last));
+    };
+    const auto write = [&](const Entity& entity)
+    {
+        const auto [firstColumn, lastColumn] = cellRange(
+                entity.getLeft() - left, entity.getRight() - left, width);
+        const auto [firstRow, lastRow] = cellRange(
+                entity.getTop() - top, entity.getBottom() - top, height);
+        if (firstColumn > lastColumn)
+            return;
+        const auto value =
+                static_cast<uint8_t>(static_cast<size_t>(entity.getType()) + 1);
+        for (auto row = firstRow; row <= lastRow; ++row)
+        {
+            std::fill(cells + row * width + firstColumn,
+                      cells + row * width + lastColumn + 1,
+                      value);
+        }
+    };
+
+    for (const auto* entity : mActiveEntities)
+    {
+        if (isObject(entity->getType()))
+            write(*entity);
+    }
+    for (const auto* entity : mActiveEntities)
+    {
+        if (!isObject(entity->getType()))
+            write(*entity);
+    }
+    write(*mMario);
+}
+
+size_t Level::getPoints() const
+{
+    return mPoints->getPoints();
+}
 
-std::vector<Event>& getEventQueue()
+const std::vector<Level::ResolvedCollision>& Level::getResolvedCollisions()
+        const
 {
-    return gEventQueue;
+    return mResolvedCollisions;
 }
 
-void addEvent(Event event)
+const sf::View& Level::getCamera() const
 {
-    gEventQueue.push_back(event);
+    return mCamera;
 }
@@ -1,12 +1,17 @@
 #ifndef SUPERMARIOBROS_LEVEL_H
 #define SUPERMARIOBROS_LEVEL_H
 
+#include "BroadPhase.h"
 #include "Event.h"
 #include "Input.h"
+#include "SaveState.h"
 #include "Text.h"
 #include "entities/Mario.h"
 
+class EventBus;
 class InvisibleWall;
+class JobSystem;
+class LevelStreamer;
 
 /*
  * Encapsulates the game logic and entities for a single
@@ -15,30 +20,129 @@ class InvisibleWall;
 class Level
 {
 public:
+    static const float DEFAULT_ACTIVITY_MARGIN;
+
     /*
      * Construct a new level from Mario and the entities in the level.
-     * Current, the Level has ownership of Mario and the entities
+     * Current, the Level has ownership of Mario and the entities.
+     * The camera starts out as the given view and follows Mario; drawFrame()
+     * applies it to the window, so the simulation itself needs no window.
      */
     Level(std::unique_ptr<Mario> mario,
           std::vector<std::unique_ptr<Entity>>&& entities,
-          sf::RenderWindow& window,
+          const sf::View& camera,
           InvisibleWall& wall);
 
+    /*
+     * Same as above, but the Level places its own invisible wall at the left
+     * edge of the camera
+     */
+    Level(std::unique_ptr<Mario> mario,
+          std::vector<std::unique_ptr<Entity>>&& entities,
+          const sf::View& camera = defaultCamera());
+    ~Level();
+
+    // The view of a freshly opened 200x200 window
+    static sf::View defaultCamera();
+
+    /*
+     * Hand the rest of the level to a streamer, which loads chunks ahead of
+     * the camera and drops the ones left behind
+     */
+    void setStreamer(std::unique_ptr<LevelStreamer> streamer);
+
+    /*
+     * Entities further than margin pixels outside the view are frozen: they
+     * are neither integrated, collided nor animated until the view comes
+     * back within range
+     */
+    void setActivityMargin(float margin);
+
     void setMarioMovementFromController(const KeyboardInput& currentInput);
 
     void executeFrame(const KeyboardInput& input);
 
-    void drawFrame(sf::RenderWindow& window);
+    void drawFrame(sf::RenderTarget& target);
+
+    /*
+     * Capture the whole simulation between frames: every entity, Mario,
+     * pending Timer actions, the clock, points, camera and streaming
+     * position. Reuse one LevelState so its buffers are only allocated once.
+     */
+    void saveState(LevelState& state) const;
+
+    /*
+     * Go back to a state saved from this Level. Entities that still exist
+     * are overwritten in place and the ones destroyed since are rebuilt.
+     */
+    void restoreState(const LevelState& state);
+
+    [[nodiscard]] const sf::View& getCamera() const;
 
     [[nodiscard]] const Mario& getMario() const;
 
-private:
-    void addEntityToFront(std::unique_ptr<Entity> entity);
+    [[nodiscard]] size_t getPoints() const;
 
+    // An observation cell with nothing in it; others hold an EntityType + 1
+    static const uint8_t EMPTY_CELL;
+
+    /*
+     * Write a width x height grid of what is around the center of the camera
+     * into cells, a row at a time from the top left, without allocating.
+     * Each cell is cellSize pixels square and holds the type of an entity
+     * overlapping it: scenery first, then everything else, then Mario on
+     * top. Only the active entities are looked at, so the cost follows the
+     * activity window and not the length of the level.
+     */
+    void writeObservation(uint8_t* cells,
+                          size_t width,
+                          size_t height,
+                          float cellSize = GRIDBOX_SIZE) const;
+
+    // A collision responded to during the last frame, seen from entity's side
+    struct ResolvedCollision
+    {
+        uint32_t entityId;
+        uint32_t otherId;
+        EntitySide side;
+    };
+
+    /*
+     * Every collision of the last frame in the order it was resolved: Mario's
+     * first, then the pairs of other entities
+     */
+    [[nodiscard]] const std::vector<ResolvedCollision>& getResolvedCollisions()
+            const;
+
+private:
     void addHUDOverlay();
 
     void scroll();
 
+    void streamChunks(const sf::View& view);
+
+    void collectActiveEntities();
+
+    /*
+     * Narrow phase over the pairs of active entities, in index order. An
+     * entity that passed clean through another this frame only responds to
+     * the earliest of the collisions its movement caused.
+     */
+    void collidePairs(JobSystem& jobSystem);
+
+    // Fill in mFirstContact from the collisions detected for the pairs
+    void findFirstContacts(const std::vector<BroadPhase::Pair>& pairs);
+
+    /*
+     * Respond to a collision between two active entities, or between Mario
+     * and one, and refresh both their projected hitboxes
+     */
+    void resolveCollision(const CollisionRecord& record,
+                          ProjectedHitboxes& hitboxes,
+                          ProjectedHitboxes& otherHitboxes);
+
+    [[nodiscard]] Entity* findEntity(uint32_t id) const;
+
     std::vector<std::shared_ptr<Text>> mTextElements;
 
     std::unique_ptr<Mario> mMario;
@@ -47,10 +151,93 @@ private:
 
     std::vector<std::unique_ptr<Entity>> mEntities;
 
-    sf::RenderWindow& mWindow;
+    // Rebuilt every frame; the entities inside the activity window. Between
+    // frames it also holds what was spawned during the last one, and never
+    // anything that has been destroyed.
+    std::vector<Entity*> mActiveEntities;
+
+    // Rebuilt every frame for the narrow phase; one entry per active entity,
+    // in the same order, then (for the hitboxes) one for Mario
+    std::vector<ProjectedHitboxes> mProjectedHitboxes;
+    std::vector<EntityType> mActiveTypes;
+
+    // Which active entities are awake after Mario's collisions, and their
+    // indices into mActiveEntities in increasing order
+    std::vector<char> mAwake;
+    std::vector<size_t> mAwakeIndices;
+
+    BroadPhase mBroadPhase;
+
+    // The bounds of each active entity's projected hitboxes, kept up to date
+    // as collision responses move them, for the broad phase and for the
+    // narrow phase to skip pairs that cannot touch. Only filled in when the
+    // broad phase is used.
+    BoundsLanes mBoundsLanes;
+
+    // Active entities that collision responses pushed outside the bounds the
+    // broad phase saw, and their indices in increasing order
+    std::vector<char> mEscaped;
+    std::vector<size_t> mEscapedIndices;
+
+    // A collision found for the pair at the given index, or for Mario and
+    // the active entity at that index
+    struct DetectedCollision
+    {
+        size_t pair;
+        CollisionRecord record;
+    };
+
+    // Collisions detected from the state before any pair was resolved, by
+    // pair index, and the per-job buffers they are gathered from
+    std::vector<DetectedCollision> mDetectedCollisions;
+    std::vector<std::vector<DetectedCollision>> mChunkCollisions;
+
+    // Active entities a collision response has changed since detection
+    std::vector<char> mTouched;
+
+    // Every pair of active entities that could collide, when there are too
+    // few of them for the broad phase
+    std::vector<BroadPhase::Pair> mAllPairs;
+
+    // A detected collision from the side of the entity whose movement
+    // caused it, for ordering each entity's collisions by time of impact
+    struct Contact
+    {
+        size_t entity;
+        size_t other;
+        float timeOfImpact;
+        bool isSwept;
+    };
+    std::vector<Contact> mContacts;
+
+    // For each active entity that passed clean through another this frame,
+    // the index of the one it met first; the only collision it causes that
+    // is responded to. NO_CONTACT for every other entity.
+    std::vector<size_t> mFirstContact;
+
+    // Mario's collisions, by entity index, found before his are resolved
+    std::vector<DetectedCollision> mMarioCollisions;
+
+    std::vector<ResolvedCollision> mResolvedCollisions;
+
+    // Holds the items spawned this frame until they go in front in one go
+    std::vector<std::unique_ptr<Entity>> mSpawnScratch;
+
+    // Holds the live entities, sorted by id, while restoring a save state
+    std::vector<std::pair<uint32_t, std::unique_ptr<Entity>>> mRestoreScratch;
+
+    float mActivityMargin;
+
+    sf::View mCamera;
 
     InvisibleWall& mWall;
 
+    // The bus the Level subscribed to when it was built, which is the one
+    // its entities publish to
+    EventBus& mEventBus;
+
+    std::unique_ptr<LevelStreamer> mStreamer;
+
     [[nodiscard]] bool physicsAreOn() const;
 
     float setVerticalVelocityDueToJumpStart(const KeyboardInput& currentInput,
@@ -58,14 +245,14 @@ private:
     float calculateVerticalAcceleration(const KeyboardInput& currentInput,
                                         float xVelocity) const;
 
-    void onPointsEarned(const Event::PointsEarned&);
-    void onItemSpawned(const Event::ItemSpawned&);
-    void onBlockShattered(const Event::BlockShattered&);
-    void onAnimationCompleted(const Event::AnimationCompleted&);
-    void onFireballSpawned(const Event::FireballSpawned&);
+    // Each handler gets every event of its type raised during the frame
+    void subscribeToEvents();
+    void onPointsEarned(const std::vector<Event::PointsEarned>& events);
+    void onItemsSpawned(const std::vector<Event::ItemSpawned>& events);
+    void onBlocksShattered(const std::vector<Event::BlockShattered>& events);
+    void onAnimationsCompleted(
+            const std::vector<Event::AnimationCompleted>& events);
+    void onFireballsSpawned(const std::vector<Event::FireballSpawned>& events);
 };
 
-std::vector<Event>& getEventQueue();
-void addEvent(Event event);
-
 #endif  // SUPERMARIOBROS_LEVEL_H
@@ -0,0 +1,147 @@
+#include "LevelBatch.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+namespace
+{
+// Instances are stepped one per job: a frame is long enough that the
+// balance matters more than the cost of a job
+const size_t INSTANCE_GRAIN_SIZE = 1;
+
+// Stepping an instance already takes a worker, so its phases run inline
+JobSystem& inlineJobSystem()
+{
+    static JobSystem jobSystem(0);
+    return jobSystem;
+}
+}
+
+LevelBatch::LevelBatch(size_t numInstances, const LevelFactory& makeLevel) :
+    mRewards(numInstances, 0),
+    mDone(numInstances, false),
+    mScores(numInstances, 0)
+{
+    for (size_t ii = 0; ii < numInstances; ++ii)
+    {
+        auto instance = std::make_unique<Instance>();
+        instance->context = SimulationContext{
+                &instance->timer, &instance->eventBus, &inlineJobSystem()};
+        {
+            ScopedSimulationContext context(instance->context);
+            instance->level = makeLevel();
+            instance->level->saveState(instance->initialState);
+        }
+        mScores[ii] = instance->level->getPoints();
+        mInstances.push_back(std::move(instance));
+    }
+}
+
+LevelBatch::~LevelBatch()
+{
+    // Entities cancel their timers as they go, so each Level has to be torn
+    // down inside its own context
+    for (auto& instance : mInstances)
+    {
+        ScopedSimulationContext context(instance->context);
+        instance->level.reset();
+    }
+}
+
+size_t LevelBatch::getNumInstances() const
+{
+    return mInstances.size();
+}
+
+void LevelBatch::step(const std::vector<KeyboardInput>& inputs)
+{
+    PROFILE_SCOPE("batch step");
+    if (inputs.size() != mInstances.size())
+        throw std::runtime_error("Got " + std::to_string(inputs.size()) +
+                                 " inputs for " +
+                                 std::to_string(mInstances.size()) +
+                                 " instances");
+
+    getJobSystem().parallelFor(mInstances.size(),
+                               INSTANCE_GRAIN_SIZE,
+                               [this, &inputs](size_t begin, size_t end, size_t)
+                               {
+                                   for (auto ii = begin; ii < end; ++ii)
+                                       stepInstance(ii, inputs[ii]);
+                               });
+}
+
+void LevelBatch::stepInstance(size_t instance, const KeyboardInput& input)
+{
+    if (mDone[instance])
+    {
+        mRewards[instance] = 0;
+        return;
+    }
+
+    auto& current = *mInstances[instance];
+    ScopedSimulationContext context(current.context);
+    current.level->executeFrame(input);
+    current.timer.incrementNumFrames();
+
+    const auto score = current.level->getPoints();
+    mRewards[instance] = static_cast<float>(score - mScores[instance]);
+    mScores[instance] = score;
+    mDone[instance] = current.level->getMario().isDead();
+}
+
+void LevelBatch::reset(size_t instance)
+{
+    auto& current = *mInstances.at(instance);
+    {
+        ScopedSimulationContext context(current.context);
+        current.level->restoreState(current.initialState);
+    }
+    mRewards[instance] = 0;
+    mDone[instance] = false;
+    mScores[instance] = current.level->getPoints();
+}
+
+void LevelBatch::writeObservations(uint8_t* cells,
+                                   size_t width,
+                                   size_t height,
+                                   float cellSize) const
+{
+    PROFILE_SCOPE("batch observations");
+    const auto cellsPerInstance = width * height;
+    getJobSystem().parallelFor(
+            mInstances.size(),
+            INSTANCE_GRAIN_SIZE,
+            [&](size_t begin, size_t end, size_t)
+            {
+                for (auto ii = begin; ii < end; ++ii)
+                    mInstances[ii]->level->writeObservation(
+                            cells + ii * cellsPerInstance,
+                            width,
+                            height,
+                            cellSize);
+            });
+}
+
+const std::vector<float>& LevelBatch::getRewards() const
+{
+    return mRewards;
+}
+
+const std::vector<char>& LevelBatch::getDone() const
+{
+    return mDone;
+}
+
+const std::vector<size_t>& LevelBatch::getScores() const
+{
+    return mScores;
+}
+
+const Level& LevelBatch::getLevel(size_t instance) const
+{
+    return *mInstances.at(instance)->level;
+}
@@ -0,0 +1,95 @@
+#ifndef SUPERMARIOBROS_LEVELBATCH_H
+#define SUPERMARIOBROS_LEVELBATCH_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "EventBus.h"
+#include "Input.h"
+#include "Level.h"
+#include "SaveState.h"
+#include "SimulationContext.h"
+#include "Timer.h"
+
+/*
+ * Many independent headless Levels stepped together, for automated
+ * playthroughs and agent training.
+ *
+ * Every instance has its own Timer and EventBus, so instances share nothing
+ * but read-only sprites. step() spreads the instances across the JobSystem;
+ * each one runs a whole frame on one thread, with its own phases serial.
+ *
+ * Instances are not stepped in lockstep across vector lanes. Entities are
+ * virtual classes with their own responses, so of a frame only the narrow
+ * phase's bounds tests could share lanes, and they are a small part of it.
+ * Each instance's activity window also follows its own Mario, so instances
+ * built from one layout soon test different pairs anyway.
+ *
+ * The results of a step are flat arrays indexed by instance: the points
+ * earned during the step (the reward), whether Mario has died, and the
+ * score so far.
+ */
+class LevelBatch
+{
+public:
+    using LevelFactory = std::function<std::unique_ptr<Level>()>;
+
+    /*
+     * Build numInstances Levels with makeLevel. It is called once per
+     * instance, inside that instance's context, so the Level subscribes to
+     * the instance's bus.
+     */
+    LevelBatch(size_t numInstances, const LevelFactory& makeLevel);
+    ~LevelBatch();
+
+    LevelBatch(const LevelBatch&) = delete;
+    LevelBatch& operator=(const LevelBatch&) = delete;
+
+    [[nodiscard]] size_t getNumInstances() const;
+
+    /*
+     * Run one frame of every instance that isn't done, giving inputs[ii] to
+     * instance ii. Instances that are done stay as they are, with no reward,
+     * until they are reset.
+     */
+    void step(const std::vector<KeyboardInput>& inputs);
+
+    // Put an instance back the way it was built
+    void reset(size_t instance);
+
+    /*
+     * Write every instance's observation grid (see Level::writeObservation())
+     * into cells, one width x height grid after another in instance order
+     */
+    void writeObservations(uint8_t* cells,
+                           size_t width,
+                           size_t height,
+                           float cellSize = GRIDBOX_SIZE) const;
+
+    [[nodiscard]] const std::vector<float>& getRewards() const;
+    [[nodiscard]] const std::vector<char>& getDone() const;
+    [[nodiscard]] const std::vector<size_t>& getScores() const;
+
+    [[nodiscard]] const Level& getLevel(size_t instance) const;
+
+private:
+    struct Instance
+    {
+        Timer timer;
+        EventBus eventBus;
+        SimulationContext context;
+        std::unique_ptr<Level> level;
+        LevelState initialState;
+    };
+
+    void stepInstance(size_t instance, const KeyboardInput& input);
+
+    std::vector<std::unique_ptr<Instance>> mInstances;
+
+    std::vector<float> mRewards;
+    std::vector<char> mDone;
+    std::vector<size_t> mScores;
+};
+
+#endif  // SUPERMARIOBROS_LEVELBATCH_H
@@ -0,0 +1,405 @@
+#include "LevelFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "Level.h"
+#include "LevelStreamer.h"
+#include "SpriteMaker.h"
+
+namespace
+{
+const char LEVEL_FILE_MAGIC[4] = {'S', 'M', 'B', 'L'};
+const uint16_t LEVEL_FILE_VERSION = 1;
+
+void appendLE16(std::vector<char>& out, uint16_t value)
+{
+    out.push_back(static_cast<char>(value & 0xff));
+    out.push_back(static_cast<char>((value >> 8) & 0xff));
+}
+
+void appendLE32(std::vector<char>& out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+        out.push_back(static_cast<char>((value >> shift) & 0xff));
+}
+
+void appendSpawn(std::vector<char>& out, const SpawnRecord& record)
+{
+    appendLE32(out, static_cast<uint32_t>(record.x));
+    appendLE32(out, static_cast<uint32_t>(record.y));
+    out.push_back(static_cast<char>(record.kind));
+    out.resize(out.size() + 3, 0);
+}
+
+void appendTileRow(std::vector<char>& out, const TileRowRecord& record)
+{
+    appendLE32(out, static_cast<uint32_t>(record.x));
+    appendLE32(out, static_cast<uint32_t>(record.y));
+    appendLE16(out, record.count);
+    out.push_back(static_cast<char>(record.kind));
+    out.push_back(0);
+}
+
+bool parseSpawnKind(const std::string& name, SpawnKind& kind)
+{
+    if (name == "goomba")
+        kind = SpawnKind::GOOMBA;
+    else if (name == "pipe")
+        kind = SpawnKind::PIPE;
+    else if (name == "breakable_block")
+        kind = SpawnKind::BREAKABLE_BLOCK;
+    else if (name == "item_block")
+        kind = SpawnKind::ITEM_BLOCK;
+    else
+        return false;
+    return true;
+}
+
+std::runtime_error parseError(size_t lineNumber, const std::string& message)
+{
+    return std::runtime_error("Level line " + std::to_string(lineNumber) +
+                              ": " + message);
+}
+
+bool endsWith(const std::string& value, const std::string& suffix)
+{
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(),
+                         suffix.size(),
+                         suffix) == 0;
+}
+
+// Modification time in nanoseconds, so an edit in the same second as the
+// last compile still counts
+int64_t modificationTime(const struct stat& info)
+{
+#ifdef __APPLE__
+    const auto& time = info.st_mtimespec;
+#else
+    const auto& time = info.st_mtim;
+#endif
+    return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+bool isStale(const std::string& compiledPath, const std::string& sourcePath)
+{
+    struct stat compiledInfo;
+    struct stat sourceInfo;
+    if (stat(compiledPath.c_str(), &compiledInfo) != 0)
+        return true;
+    if (stat(sourcePath.c_str(), &sourceInfo) != 0)
+        return false;
+    // Equal times may be a coarse filesystem clock, so recompile to be safe
+    return modificationTime(compiledInfo) <= modificationTime(sourceInfo);
+}
+
+// Written to a file of its own and renamed over the cache, so a crash or
+// another run never sees a partial file. Returns false if it couldn't be.
+bool writeCompiledLevel(const std::string& compiledPath,
+                        const std::vector<char>& compiled)
+{
+    const auto tempPath =
+            compiledPath + ".tmp" + std::to_string(static_cast<long>(getpid()));
+    std::ofstream output(tempPath, std::ios::binary);
+    output.write(compiled.data(), compiled.size());
+    output.close();
+    if (output && std::rename(tempPath.c_str(), compiledPath.c_str()) == 0)
+        return true;
+    std::remove(tempPath.c_str());
+    return false;
+}
+}
+
+std::vector<char> compileLevelText(std::istream& input)
+{
+    std::vector<SpawnRecord> spawns;
+    std::vector<TileRowRecord> tileRows;
+    bool hasMario = false;
+    int32_t marioX = 0;
+    int32_t marioY = 0;
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        ++lineNumber;
+        const auto comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name))
+            continue;
+
+        int32_t x = 0;
+        int32_t y = 0;
+        if (!(fields >> x >> y))
+            throw parseError(lineNumber, "expected x and y after " + name);
+
+        SpawnKind spawnKind;
+        if (name == "mario")
+        {
+            if (hasMario)
+                throw parseError(lineNumber, "Mario is placed twice");
+            hasMario = true;
+            marioX = x;
+            marioY = y;
+        }
+        else if (name == "ground")
+        {
+            int32_t count = 0;
+            if (!(fields >> count) || count <= 0 ||
+                count > std::numeric_limits<uint16_t>::max())
+                throw parseError(lineNumber, "expected a tile count");
+            tileRows.push_back(TileRowRecord{
+                    x, y, static_cast<uint16_t>(count), TileKind::GROUND, 0});
+        }
+        else if (parseSpawnKind(name, spawnKind))
+        {
+            spawns.push_back(SpawnRecord{x, y, spawnKind, {}});
+        }
+        else
+        {
+            throw parseError(lineNumber, "unknown entity '" + name + "'");
+        }
+
+        std::string trailing;
+        if (fields >> trailing)
+            throw parseError(lineNumber, "unexpected '" + trailing + "'");
+    }
+
+    if (!hasMario)
+        throw std::runtime_error("Level does not place Mario");
+
+    std::stable_sort(spawns.begin(),
+                     spawns.end(),
+                     [](const SpawnRecord& lhs, const SpawnRecord& rhs)
+                     { return lhs.x < rhs.x; });
+    std::stable_sort(tileRows.begin(),
+                     tileRows.end(),
+                     [](const TileRowRecord& lhs, const TileRowRecord& rhs)
+                     { return lhs.x < rhs.x; });
+
+    std::vector<char> result;
+    result.reserve(sizeof(LevelFileHeader) +
+                   spawns.size() * sizeof(SpawnRecord) +
+                   tileRows.size() * sizeof(TileRowRecord));
+    for (const auto character : LEVEL_FILE_MAGIC)
+        result.push_back(character);
+    appendLE16(result, LEVEL_FILE_VERSION);
+    appendLE16(result, 0);
+    appendLE32(result, static_cast<uint32_t>(marioX));
+    appendLE32(result, static_cast<uint32_t>(marioY));
+    appendLE32(result, static_cast<uint32_t>(spawns.size()));
+    appendLE32(result, static_cast<uint32_t>(tileRows.size()));
+    for (const auto& spawn : spawns)
+        appendSpawn(result, spawn);
+    for (const auto& tileRow : tileRows)
+        appendTileRow(result, tileRow);
+    return result;
+}
+
+LevelFile::LevelFile(const char* data, size_t size) :
+    mData(data),
+    mSize(size),
+    mIsMapped(true)
+{
+}
+
+LevelFile LevelFile::map(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Unable to open level " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        throw std::runtime_error("Unable to read level " + path);
+    }
+
+    const auto size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        throw std::runtime_error("Unable to map level " + path);
+
+    LevelFile levelFile(static_cast<const char*>(data), size);
+    levelFile.validate();
+    return levelFile;
+}
+
+LevelFile LevelFile::fromBuffer(std::vector<char> buffer)
+{
+    LevelFile levelFile(buffer.data(), buffer.size());
+    levelFile.mIsMapped = false;
+    levelFile.mBuffer = std::move(buffer);
+    levelFile.validate();
+    return levelFile;
+}
+
+LevelFile LevelFile::fromText(const std::string& text)
+{
+    std::istringstream input(text);
+    return fromBuffer(compileLevelText(input));
+}
+
+LevelFile::LevelFile(LevelFile&& other) noexcept :
+    mData(other.mData),
+    mSize(other.mSize),
+    mIsMapped(other.mIsMapped),
+    mBuffer(std::move(other.mBuffer))
+{
+    other.mData = nullptr;
+    other.mSize = 0;
+    other.mIsMapped = false;
+}
+
+LevelFile& LevelFile::operator=(LevelFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        mData = other.mData;
+        mSize = other.mSize;
+        mIsMapped = other.mIsMapped;
+        mBuffer = std::move(other.mBuffer);
+        other.mData = nullptr;
+        other.mSize = 0;
+        other.mIsMapped = false;
+    }
+    return *this;
+}
+
+LevelFile::~LevelFile()
+{
+    release();
+}
+
+void LevelFile::release()
+{
+    if (mIsMapped && mData)
+        munmap(const_cast<char*>(mData), mSize);
+    mData = nullptr;
+    mSize = 0;
+    mIsMapped = false;
+    mBuffer.clear();
+}
+
+void LevelFile::validate() const
+{
+    if (mSize < sizeof(LevelFileHeader) ||
+        std::memcmp(header().magic, LEVEL_FILE_MAGIC, 4) != 0)
+        throw std::runtime_error("Not a compiled level file");
+    if (header().version != LEVEL_FILE_VERSION)
+        throw std::runtime_error("Unsupported level file version " +
+                                 std::to_string(header().version));
+
+    const auto expectedSize =
+            sizeof(LevelFileHeader) +
+            header().numSpawns * sizeof(SpawnRecord) +
+            static_cast<size_t>(header().numTileRows) * sizeof(TileRowRecord);
+    if (mSize != expectedSize)
+        throw std::runtime_error("Truncated level file");
+}
+
+const LevelFileHeader& LevelFile::header() const
+{
+    return *reinterpret_cast<const LevelFileHeader*>(mData);
+}
+
+sf::Vector2f LevelFile::getMarioPosition() const
+{
+    return {static_cast<float>(header().marioX),
+            static_cast<float>(header().marioY)};
+}
+
+const SpawnRecord* LevelFile::spawnsBegin() const
+{
+    return reinterpret_cast<const SpawnRecord*>(mData +
+                                                sizeof(LevelFileHeader));
+}
+
+const SpawnRecord* LevelFile::spawnsEnd() const
+{
+    return spawnsBegin() + getNumSpawns();
+}
+
+size_t LevelFile::getNumSpawns() const
+{
+    return header().numSpawns;
+}
+
+const TileRowRecord* LevelFile::tileRowsBegin() const
+{
+    return reinterpret_cast<const TileRowRecord*>(spawnsEnd());
+}
+
+const TileRowRecord* LevelFile::tileRowsEnd() const
+{
+    return tileRowsBegin() + getNumTileRows();
+}
+
+size_t LevelFile::getNumTileRows() const
+{
+    return header().numTileRows;
+}
+
+LevelFile openLevelFile(const std::string& path)
+{
+    if (!endsWith(path, ".txt"))
+        return LevelFile::map(path);
+
+    const auto compiledPath = path.substr(0, path.size() - 4) + ".lvl";
+    if (!isStale(compiledPath, path))
+    {
+        try
+        {
+            return LevelFile::map(compiledPath);
+        }
+        catch (const std::runtime_error&)
+        {
+            // Written by an older version, or damaged; rebuilt from the text
+        }
+    }
+
+    std::ifstream source(path);
+    if (!source)
+        throw std::runtime_error("Unable to open level " + path);
+    const auto compiled = compileLevelText(source);
+
+    // Fall back to an in-memory level if the cache can't be written
+    if (!writeCompiledLevel(compiledPath, compiled))
+        return LevelFile::fromBuffer(compiled);
+    return LevelFile::map(compiledPath);
+}
+
+std::unique_ptr<Level> loadLevel(const LevelFile& levelFile,
+                                 const sf::View& camera)
+{
+    auto& spriteMaker = getSpriteMaker();
+    auto mario = std::make_unique<Mario>(spriteMaker->playerTexture,
+                                         levelFile.getMarioPosition());
+    auto level = std::make_unique<Level>(
+            std::move(mario), std::vector<std::unique_ptr<Entity>>(), camera);
+    level->setStreamer(std::make_unique<LevelStreamer>(levelFile, *spriteMaker));
+    return level;
+}
+
+std::unique_ptr<Level> loadLevel(const LevelFile& levelFile)
+{
+    return loadLevel(levelFile, Level::defaultCamera());
+}
@@ -0,0 +1,142 @@
+#ifndef SUPERMARIOBROS_LEVELFILE_H
+#define SUPERMARIOBROS_LEVELFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SFML/Graphics.hpp"
+
+class Level;
+
+/*
+ * Levels are authored as text and compiled to a little-endian binary blob.
+ *
+ * Text form, one entity per line ('#' starts a comment):
+ *
+ *     mario 60 90
+ *     pipe 130 100
+ *     goomba 200 50
+ *     breakable_block 40 75
+ *     item_block 56 75
+ *     ground 0 132 20        <- tile row: x, y, number of tiles
+ *
+ * Binary form: a LevelFileHeader followed by numSpawns SpawnRecords and
+ * numTileRows TileRowRecords. Both record arrays are sorted by x so that
+ * the level can be consumed from left to right.
+ */
+
+enum class SpawnKind : uint8_t
+{
+    GOOMBA,
+    PIPE,
+    BREAKABLE_BLOCK,
+    ITEM_BLOCK,
+};
+
+enum class TileKind : uint8_t
+{
+    GROUND,
+};
+
+struct LevelFileHeader
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    int32_t marioX;
+    int32_t marioY;
+    uint32_t numSpawns;
+    uint32_t numTileRows;
+};
+
+struct SpawnRecord
+{
+    int32_t x;
+    int32_t y;
+    SpawnKind kind;
+    uint8_t padding[3];
+};
+
+struct TileRowRecord
+{
+    int32_t x;
+    int32_t y;
+    uint16_t count;
+    TileKind kind;
+    uint8_t padding;
+};
+
+static_assert(sizeof(LevelFileHeader) == 24, "Unexpected header layout");
+static_assert(sizeof(SpawnRecord) == 12, "Unexpected spawn record layout");
+static_assert(sizeof(TileRowRecord) == 12, "Unexpected tile row layout");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Compiled levels are mapped in place and are little-endian");
+
+/*
+ * Parse the text form of a level and return the compiled binary blob.
+ * Throws std::runtime_error (with the offending line number) on bad input.
+ */
+std::vector<char> compileLevelText(std::istream& input);
+
+/*
+ * A read-only view over a compiled level. The records are read in place from
+ * either a memory-mapped file or an owned buffer; nothing is copied.
+ */
+class LevelFile
+{
+public:
+    static LevelFile map(const std::string& path);
+    static LevelFile fromBuffer(std::vector<char> buffer);
+    // Compile the text form of a level (see compileLevelText()) and view it
+    static LevelFile fromText(const std::string& text);
+
+    LevelFile(LevelFile&& other) noexcept;
+    LevelFile& operator=(LevelFile&& other) noexcept;
+    LevelFile(const LevelFile&) = delete;
+    LevelFile& operator=(const LevelFile&) = delete;
+    ~LevelFile();
+
+    [[nodiscard]] sf::Vector2f getMarioPosition() const;
+
+    [[nodiscard]] const SpawnRecord* spawnsBegin() const;
+    [[nodiscard]] const SpawnRecord* spawnsEnd() const;
+    [[nodiscard]] size_t getNumSpawns() const;
+
+    [[nodiscard]] const TileRowRecord* tileRowsBegin() const;
+    [[nodiscard]] const TileRowRecord* tileRowsEnd() const;
+    [[nodiscard]] size_t getNumTileRows() const;
+
+private:
+    LevelFile(const char* data, size_t size);
+
+    void validate() const;
+    void release();
+
+    [[nodiscard]] const LevelFileHeader& header() const;
+
+    const char* mData;
+    size_t mSize;
+    bool mIsMapped;
+    std::vector<char> mBuffer;
+};
+
+/*
+ * Open a level by path. A ".txt" level is compiled to a sibling ".lvl" file
+ * whenever the binary is missing, older than the text or fails to load, and
+ * the binary is then mapped.
+ */
+LevelFile openLevelFile(const std::string& path);
+
+/*
+ * Instantiate Mario and stream the rest of the level in as the camera
+ * scrolls. The LevelFile must outlive the returned Level.
+ */
+std::unique_ptr<Level> loadLevel(const LevelFile& levelFile,
+                                 const sf::View& camera);
+std::unique_ptr<Level> loadLevel(const LevelFile& levelFile);
+
+#endif  // SUPERMARIOBROS_LEVELFILE_H
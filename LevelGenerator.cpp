@@ -0,0 +1,199 @@
+#include "LevelGenerator.h"
+
+#include <entities/Ground.h>
+
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Level.h"
+#include "LevelStreamer.h"
+#include "SpriteMaker.h"
+
+namespace
+{
+const size_t START_COLUMNS = 8;
+const size_t PIPE_COLUMNS = 2;
+const int32_t MARIO_X = 2 * GRIDBOX_SIZE;
+const int32_t MARIO_Y = 90;
+const int32_t GROUND_Y = 132;
+const int32_t PIPE_Y = GROUND_Y - 2 * GRIDBOX_SIZE;
+const int32_t BLOCK_Y = 75;
+const int32_t GOOMBA_Y = 50;
+const int32_t GOOMBA_SPACING = 24;
+const float ITEM_BLOCK_CHANCE = 0.25f;
+
+// The distributions in <random> differ between standard libraries, so draws
+// are taken straight from the engine, whose output is fully specified
+class Random
+{
+public:
+    explicit Random(uint32_t seed) :
+        mEngine(seed)
+    {
+    }
+
+    size_t below(size_t bound)
+    {
+        return mEngine() % bound;
+    }
+
+    bool chance(float probability)
+    {
+        return mEngine() < probability * 4294967296.0;
+    }
+
+private:
+    std::mt19937 mEngine;
+};
+
+/*
+ * Split the columns after the start into count equal shares and pick a
+ * random starting column in each share such that a feature width columns
+ * wide stays inside it
+ */
+std::vector<size_t> spreadColumns(Random& random,
+                                  size_t numColumns,
+                                  size_t count,
+                                  size_t width,
+                                  const std::string& what)
+{
+    std::vector<size_t> columns;
+    if (count == 0)
+        return columns;
+
+    const auto share = (numColumns - START_COLUMNS) / count;
+    if (share < width || share == 0)
+        throw std::runtime_error("Level is too short for " +
+                                 std::to_string(count) + " " + what);
+    columns.reserve(count);
+    for (size_t ii = 0; ii < count; ++ii)
+        columns.push_back(START_COLUMNS + ii * share +
+                          random.below(share - width + 1));
+    return columns;
+}
+
+int32_t columnToX(size_t column)
+{
+    return static_cast<int32_t>(column * GRIDBOX_SIZE);
+}
+}
+
+void writeGeneratedLevel(const LevelGeneratorOptions& options,
+                         std::ostream& output)
+{
+    const auto numColumns = options.numColumns;
+    if (numColumns < START_COLUMNS)
+        throw std::runtime_error("Level must be at least " +
+                                 std::to_string(START_COLUMNS) +
+                                 " columns long");
+
+    Random random(options.seed);
+    std::vector<bool> solid(numColumns, true);
+    for (auto column = START_COLUMNS; column < numColumns; ++column)
+        solid[column] = random.chance(options.groundDensity);
+
+    const auto pipes = spreadColumns(
+            random, numColumns, options.numPipes, PIPE_COLUMNS, "pipes");
+    // Pipes always stand on the ground
+    for (const auto column : pipes)
+        solid[column] = solid[column + 1] = true;
+
+    const auto blockRows = spreadColumns(random,
+                                         numColumns,
+                                         options.numBlockRows,
+                                         options.blocksPerRow,
+                                         "block rows");
+
+    const auto swarmWidth =
+            (options.goombasPerSwarm * GOOMBA_SPACING + GRIDBOX_SIZE - 1) /
+            GRIDBOX_SIZE;
+    const auto swarms = spreadColumns(random,
+                                      numColumns,
+                                      options.numGoombaSwarms,
+                                      swarmWidth,
+                                      "Goomba swarms");
+
+    output << "# Generated from seed " << options.seed << "\n";
+    output << "mario " << MARIO_X << " " << MARIO_Y << "\n";
+
+    // One row per run of solid columns
+    const size_t maxRowLength = std::numeric_limits<uint16_t>::max();
+    for (size_t column = 0; column < numColumns;)
+    {
+        if (!solid[column])
+        {
+            ++column;
+            continue;
+        }
+        auto end = column;
+        while (end < numColumns && solid[end] && end - column < maxRowLength)
+            ++end;
+        output << "ground " << columnToX(column) << " " << GROUND_Y << " "
+               << end - column << "\n";
+        column = end;
+    }
+
+    for (const auto column : pipes)
+        output << "pipe " << columnToX(column) << " " << PIPE_Y << "\n";
+
+    for (const auto column : blockRows)
+    {
+        for (size_t ii = 0; ii < options.blocksPerRow; ++ii)
+        {
+            output << (random.chance(ITEM_BLOCK_CHANCE) ? "item_block "
+                                                        : "breakable_block ")
+                   << columnToX(column + ii) << " " << BLOCK_Y << "\n";
+        }
+    }
+
+    for (const auto column : swarms)
+    {
+        for (size_t ii = 0; ii < options.goombasPerSwarm; ++ii)
+        {
+            output << "goomba "
+                   << columnToX(column) + static_cast<int32_t>(ii) *
+                                                  GOOMBA_SPACING
+                   << " " << GOOMBA_Y << "\n";
+        }
+    }
+}
+
+LevelFile generateLevelFile(const LevelGeneratorOptions& options)
+{
+    std::stringstream text;
+    writeGeneratedLevel(options, text);
+    return LevelFile::fromBuffer(compileLevelText(text));
+}
+
+std::unique_ptr<Level> generateLevel(const LevelGeneratorOptions& options)
+{
+    const auto levelFile = generateLevelFile(options);
+    const auto& spriteMaker = *getSpriteMaker();
+
+    size_t numTiles = 0;
+    for (auto row = levelFile.tileRowsBegin(); row != levelFile.tileRowsEnd();
+         ++row)
+        numTiles += row->count;
+
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.reserve(levelFile.getNumSpawns() + numTiles);
+    for (auto spawn = levelFile.spawnsBegin(); spawn != levelFile.spawnsEnd();
+         ++spawn)
+        entities.push_back(LevelStreamer::createSpawn(*spawn, spriteMaker));
+    for (auto row = levelFile.tileRowsBegin(); row != levelFile.tileRowsEnd();
+         ++row)
+    {
+        for (uint16_t tile = 0; tile < row->count; ++tile)
+            entities.push_back(std::make_unique<Ground>(
+                    spriteMaker.inanimateObjectTexture,
+                    sf::Vector2f(row->x + tile * GRIDBOX_SIZE, row->y)));
+    }
+
+    auto mario = std::make_unique<Mario>(spriteMaker.playerTexture,
+                                         levelFile.getMarioPosition());
+    return std::make_unique<Level>(std::move(mario), std::move(entities));
+}
@@ -0,0 +1,56 @@
+#ifndef SUPERMARIOBROS_LEVELGENERATOR_H
+#define SUPERMARIOBROS_LEVELGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+#include "LevelFile.h"
+
+class Level;
+
+/*
+ * Seeded generator for stress levels, used to see how frame time scales
+ * with the size of a level. The same options always produce the same level,
+ * on every platform.
+ *
+ * The level is a single floor of ground tiles with pits in it. Pipes, block
+ * rows and Goomba swarms are spread evenly along it, each at a random
+ * column within its share of the level. The first few columns are always
+ * solid and left empty for Mario.
+ */
+struct LevelGeneratorOptions
+{
+    uint32_t seed = 1;
+
+    // Length of the level in tiles
+    size_t numColumns = 200;
+
+    // Chance that a column has ground under it; the rest are pits
+    float groundDensity = 0.9f;
+
+    size_t numPipes = 8;
+    size_t numBlockRows = 6;
+    size_t blocksPerRow = 4;
+    size_t numGoombaSwarms = 6;
+    size_t goombasPerSwarm = 3;
+};
+
+/*
+ * Write the level in the text form described in LevelFile.h. Throws
+ * std::runtime_error if the level is too short to fit everything.
+ */
+void writeGeneratedLevel(const LevelGeneratorOptions& options,
+                         std::ostream& output);
+
+LevelFile generateLevelFile(const LevelGeneratorOptions& options);
+
+/*
+ * Generate a level and instantiate all of it up front instead of streaming
+ * it, so that every entity is resident and the level does not depend on a
+ * LevelFile.
+ */
+std::unique_ptr<Level> generateLevel(const LevelGeneratorOptions& options);
+
+#endif  // SUPERMARIOBROS_LEVELGENERATOR_H
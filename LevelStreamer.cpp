@@ -0,0 +1,179 @@
+#include "LevelStreamer.h"
+
+#include <entities/Block.h>
+#include <entities/Goomba.h>
+#include <entities/Ground.h>
+#include <entities/Pipe.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "SpriteMaker.h"
+
+namespace
+{
+bool isEnemySpawn(SpawnKind kind)
+{
+    return kind == SpawnKind::GOOMBA;
+}
+}
+
+const float LevelStreamer::CHUNK_WIDTH = 16 * GRIDBOX_SIZE;
+const float LevelStreamer::ENEMY_SPAWN_MARGIN = 2 * GRIDBOX_SIZE;
+
+LevelStreamer::LevelStreamer(const LevelFile& levelFile,
+                             const SpriteMaker& spriteMaker) :
+    mLevelFile(levelFile),
+    mSpriteMaker(spriteMaker),
+    mNextSpawn(levelFile.spawnsBegin()),
+    mNextEnemy(levelFile.spawnsBegin()),
+    mNextTileRow(levelFile.tileRowsBegin()),
+    mLoadedUntil(0)
+{
+}
+
+void LevelStreamer::loadAhead(float viewRight,
+                              std::vector<std::unique_ptr<Entity>>& entities)
+{
+    while (mLoadedUntil < viewRight + CHUNK_WIDTH &&
+           (mNextSpawn != mLevelFile.spawnsEnd() ||
+            mNextTileRow != mLevelFile.tileRowsEnd() ||
+            !mOpenTileRows.empty()))
+    {
+        mLoadedUntil += CHUNK_WIDTH;
+        loadChunk(mLoadedUntil, entities);
+    }
+    spawnEnemies(viewRight, entities);
+}
+
+void LevelStreamer::spawnEnemies(
+        float viewRight, std::vector<std::unique_ptr<Entity>>& entities)
+{
+    for (; mNextEnemy != mLevelFile.spawnsEnd() &&
+           mNextEnemy->x <= viewRight + ENEMY_SPAWN_MARGIN;
+         ++mNextEnemy)
+    {
+        if (isEnemySpawn(mNextEnemy->kind))
+            entities.push_back(createSpawn(*mNextEnemy, mSpriteMaker));
+    }
+}
+
+void LevelStreamer::loadChunk(float chunkEnd,
+                              std::vector<std::unique_ptr<Entity>>& entities)
+{
+    // The first chunk also picks up anything placed left of x = 0
+    for (; mNextSpawn != mLevelFile.spawnsEnd() && mNextSpawn->x < chunkEnd;
+         ++mNextSpawn)
+    {
+        if (!isEnemySpawn(mNextSpawn->kind))
+            entities.push_back(createSpawn(*mNextSpawn, mSpriteMaker));
+    }
+
+    for (; mNextTileRow != mLevelFile.tileRowsEnd() &&
+           mNextTileRow->x < chunkEnd;
+         ++mNextTileRow)
+    {
+        mOpenTileRows.push_back(OpenTileRow{mNextTileRow, 0});
+    }
+
+    for (auto& open : mOpenTileRows)
+    {
+        for (; open.nextTile < open.row->count; ++open.nextTile)
+        {
+            const float x = open.row->x + open.nextTile * GRIDBOX_SIZE;
+            if (x >= chunkEnd)
+                break;
+            entities.push_back(std::make_unique<Ground>(
+                    mSpriteMaker.inanimateObjectTexture,
+                    sf::Vector2f(x, open.row->y)));
+        }
+    }
+
+    mOpenTileRows.erase(std::remove_if(mOpenTileRows.begin(),
+                                       mOpenTileRows.end(),
+                                       [](const OpenTileRow& open)
+                                       { return open.nextTile ==
+                                                open.row->count; }),
+                        mOpenTileRows.end());
+}
+
+void LevelStreamer::unloadBehind(
+        float viewLeft,
+        std::vector<std::unique_ptr<Entity>>& entities,
+        const Entity* pinned)
+{
+    const auto chunkStart = std::floor(viewLeft / CHUNK_WIDTH) * CHUNK_WIDTH;
+    entities.erase(std::remove_if(entities.begin(),
+                                  entities.end(),
+                                  [&](const std::unique_ptr<Entity>& entity)
+                                  {
+                                      return entity.get() != pinned &&
+                                             entity->getRight() < chunkStart;
+                                  }),
+                   entities.end());
+}
+
+std::unique_ptr<Entity> LevelStreamer::createSpawn(
+        const SpawnRecord& spawn,
+        const SpriteMaker& spriteMaker)
+{
+    const sf::Vector2f position(spawn.x, spawn.y);
+    switch (spawn.kind)
+    {
+    case SpawnKind::GOOMBA:
+        return std::make_unique<Goomba>(spriteMaker.enemyTexture, position);
+    case SpawnKind::PIPE:
+        return std::make_unique<Pipe>(spriteMaker.inanimateObjectTexture,
+                                      position);
+    case SpawnKind::BREAKABLE_BLOCK:
+        return std::make_unique<BreakableBlock>(
+                spriteMaker.inanimateObjectTexture, position);
+    case SpawnKind::ITEM_BLOCK:
+        return std::make_unique<ItemBlock>(spriteMaker.inanimateObjectTexture,
+                                           position);
+    }
+    throw std::runtime_error("Unhandled spawn kind");
+}
+
+float LevelStreamer::getLoadedUntil() const
+{
+    return mLoadedUntil;
+}
+
+bool LevelStreamer::isExhausted() const
+{
+    return mNextSpawn == mLevelFile.spawnsEnd() &&
+           mNextEnemy == mLevelFile.spawnsEnd() &&
+           mNextTileRow == mLevelFile.tileRowsEnd() && mOpenTileRows.empty();
+}
+
+void LevelStreamer::saveState(StreamerState& state) const
+{
+    state.nextSpawn = mNextSpawn - mLevelFile.spawnsBegin();
+    state.nextEnemy = mNextEnemy - mLevelFile.spawnsBegin();
+    state.nextTileRow = mNextTileRow - mLevelFile.tileRowsBegin();
+    state.openTileRows.clear();
+    for (const auto& open : mOpenTileRows)
+    {
+        state.openTileRows.push_back(StreamerState::OpenTileRow{
+                static_cast<uint32_t>(open.row - mLevelFile.tileRowsBegin()),
+                open.nextTile});
+    }
+    state.loadedUntil = mLoadedUntil;
+}
+
+void LevelStreamer::restoreState(const StreamerState& state)
+{
+    mNextSpawn = mLevelFile.spawnsBegin() + state.nextSpawn;
+    mNextEnemy = mLevelFile.spawnsBegin() + state.nextEnemy;
+    mNextTileRow = mLevelFile.tileRowsBegin() + state.nextTileRow;
+    mOpenTileRows.clear();
+    for (const auto& open : state.openTileRows)
+    {
+        mOpenTileRows.push_back(
+                OpenTileRow{mLevelFile.tileRowsBegin() + open.row,
+                            open.nextTile});
+    }
+    mLoadedUntil = state.loadedUntil;
+}
@@ -0,0 +1,89 @@
+#ifndef SUPERMARIOBROS_LEVELSTREAMER_H
+#define SUPERMARIOBROS_LEVELSTREAMER_H
+
+#include <memory>
+#include <vector>
+
+#include "Entity.h"
+#include "LevelFile.h"
+#include "SaveState.h"
+
+class SpriteMaker;
+
+/*
+ * Streams a compiled level into a Level in fixed-width chunks. Chunks are
+ * instantiated ahead of the camera and everything that falls behind it is
+ * destroyed. The camera only ever scrolls forward, so a dropped chunk is
+ * never loaded again and the number of resident entities only depends on
+ * the width of the view.
+ *
+ * Enemies are not part of a chunk. Their spawn records stay in the level
+ * file until the right edge of the view comes within ENEMY_SPAWN_MARGIN of
+ * them, as in the original game, so live enemies are bounded by the screen
+ * rather than by the level.
+ *
+ * The LevelFile must outlive the streamer.
+ */
+class LevelStreamer
+{
+public:
+    static const float CHUNK_WIDTH;
+    static const float ENEMY_SPAWN_MARGIN;
+
+    LevelStreamer(const LevelFile& levelFile, const SpriteMaker& spriteMaker);
+
+    /*
+     * Instantiate every chunk that starts before viewRight plus one chunk of
+     * lookahead, and every enemy within ENEMY_SPAWN_MARGIN of viewRight
+     */
+    void loadAhead(float viewRight,
+                   std::vector<std::unique_ptr<Entity>>& entities);
+
+    /*
+     * Destroy every entity that lies entirely in a chunk left of viewLeft.
+     * The pinned entity (the invisible wall) is always kept.
+     */
+    static void unloadBehind(float viewLeft,
+                             std::vector<std::unique_ptr<Entity>>& entities,
+                             const Entity* pinned);
+
+    [[nodiscard]] float getLoadedUntil() const;
+
+    [[nodiscard]] bool isExhausted() const;
+
+    void saveState(StreamerState& state) const;
+    void restoreState(const StreamerState& state);
+
+    // Instantiate the entity a spawn record describes
+    static std::unique_ptr<Entity> createSpawn(const SpawnRecord& spawn,
+                                               const SpriteMaker& spriteMaker);
+
+private:
+    struct OpenTileRow
+    {
+        const TileRowRecord* row;
+        uint16_t nextTile;
+    };
+
+    void loadChunk(float chunkEnd,
+                   std::vector<std::unique_ptr<Entity>>& entities);
+
+    void spawnEnemies(float viewRight,
+                      std::vector<std::unique_ptr<Entity>>& entities);
+
+    const LevelFile& mLevelFile;
+    const SpriteMaker& mSpriteMaker;
+
+    // Both cursors walk the same x-sorted spawn records; the first one skips
+    // enemies and the second one skips everything else
+    const SpawnRecord* mNextSpawn;
+    const SpawnRecord* mNextEnemy;
+    const TileRowRecord* mNextTileRow;
+
+    // Tile rows that have started but still have tiles in later chunks
+    std::vector<OpenTileRow> mOpenTileRows;
+
+    float mLoadedUntil;
+};
+
+#endif  // SUPERMARIOBROS_LEVELSTREAMER_H
@@ -0,0 +1,135 @@
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+struct ProfileSample
+{
+    const char* name;
+    int64_t startNanoseconds;
+    int64_t durationNanoseconds;
+};
+
+// Written by one thread only; the count is published with release order so
+// a reader sees complete samples
+class SampleRing
+{
+public:
+    static const size_t CAPACITY = 1 << 16;
+
+    explicit SampleRing(uint32_t threadId) :
+        mThreadId(threadId)
+    {
+    }
+
+    void push(const ProfileSample& sample)
+    {
+        const auto numWritten = mNumWritten.load(std::memory_order_relaxed);
+        mSamples[numWritten % CAPACITY] = sample;
+        mNumWritten.store(numWritten + 1, std::memory_order_release);
+    }
+
+    template <typename Visitor>
+    void forEachSample(Visitor visit) const
+    {
+        const auto numWritten = mNumWritten.load(std::memory_order_acquire);
+        const auto first = numWritten > CAPACITY ? numWritten - CAPACITY : 0;
+        for (auto ii = first; ii < numWritten; ++ii)
+            visit(mSamples[ii % CAPACITY]);
+    }
+
+    uint32_t getThreadId() const
+    {
+        return mThreadId;
+    }
+
+private:
+    std::array<ProfileSample, CAPACITY> mSamples;
+    std::atomic<uint64_t> mNumWritten{0};
+    const uint32_t mThreadId;
+};
+
+// Rings outlive their threads so that a dump still sees finished threads.
+// The lock is only taken once per thread and when dumping.
+std::mutex gRingsMutex;
+std::vector<std::unique_ptr<SampleRing>> gRings;
+
+SampleRing& getThreadRing()
+{
+    thread_local SampleRing* ring = nullptr;
+    if (!ring)
+    {
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        gRings.push_back(std::make_unique<SampleRing>(
+                static_cast<uint32_t>(gRings.size())));
+        ring = gRings.back().get();
+    }
+    return *ring;
+}
+
+int64_t nowNanoseconds()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - epoch)
+            .count();
+}
+}
+
+ProfileScope::ProfileScope(const char* name) :
+    mName(name),
+    mStartNanoseconds(nowNanoseconds())
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+    getThreadRing().push(ProfileSample{
+            mName, mStartNanoseconds, nowNanoseconds() - mStartNanoseconds});
+}
+
+void writeChromeTrace(std::ostream& output)
+{
+    std::lock_guard<std::mutex> lock(gRingsMutex);
+
+    // Complete ("X") events, timestamps in microseconds
+    output << "{\"traceEvents\":[";
+    bool first = true;
+    output << std::fixed << std::setprecision(3);
+    for (const auto& ring : gRings)
+    {
+        ring->forEachSample(
+                [&](const ProfileSample& sample)
+                {
+                    output << (first ? "\n" : ",\n") << "{\"name\":\""
+                           << sample.name << "\",\"ph\":\"X\",\"pid\":1,"
+                           << "\"tid\":" << ring->getThreadId()
+                           << ",\"ts\":" << sample.startNanoseconds / 1000.0
+                           << ",\"dur\":"
+                           << sample.durationNanoseconds / 1000.0 << "}";
+                    first = false;
+                });
+    }
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void writeChromeTrace(const std::string& path)
+{
+    std::ofstream output(path);
+    if (!output)
+        throw std::runtime_error("Unable to write profile to " + path);
+    writeChromeTrace(output);
+}
+
+#endif  // ENABLE_PROFILER
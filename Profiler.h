@@ -0,0 +1,50 @@
+#ifndef SUPERMARIOBROS_PROFILER_H
+#define SUPERMARIOBROS_PROFILER_H
+
+/*
+ * Scoped timers for finding out where frame time goes. Configure with
+ * -DENABLE_PROFILER=1 to turn them on; otherwise PROFILE_SCOPE expands to
+ * nothing and none of this is compiled.
+ *
+ * Each thread records into its own fixed-size ring buffer, so recording
+ * never takes a lock; once a buffer is full the oldest samples are
+ * overwritten. writeChromeTrace() dumps every thread's samples as Chrome
+ * trace event JSON, which chrome://tracing and ui.perfetto.dev open
+ * directly. Call it while the recording threads are idle.
+ */
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+class ProfileScope
+{
+public:
+    // name must be a string literal (or otherwise outlive the profile)
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* mName;
+    int64_t mStartNanoseconds;
+};
+
+void writeChromeTrace(std::ostream& output);
+void writeChromeTrace(const std::string& path);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+
+#endif  // ENABLE_PROFILER
+
+#endif  // SUPERMARIOBROS_PROFILER_H
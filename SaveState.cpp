@@ -0,0 +1,8 @@
+#include "SaveState.h"
+
+size_t LevelState::getNumBytes() const
+{
+    return sizeof(*this) + entities.size() * sizeof(EntityState) +
+           timedActions.size() * sizeof(TimedActionState) +
+           streamer.openTileRows.size() * sizeof(StreamerState::OpenTileRow);
+}
@@ -0,0 +1,144 @@
+#ifndef SUPERMARIOBROS_SAVESTATE_H
+#define SUPERMARIOBROS_SAVESTATE_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Timer.h"
+
+/*
+ * The mutable state of a Level, laid out as plain data so that a snapshot is
+ * a handful of memcpys. Everything that is fixed at construction (textures,
+ * animation frame lists, constants) stays with the live objects; restoring
+ * overwrites the rest in place and only rebuilds the entities that were
+ * destroyed since the snapshot was taken.
+ *
+ * Entities are matched by id. Timer actions name their owner by id for the
+ * same reason. Plain Timer callbacks belong to whoever scheduled them and
+ * are neither saved nor rewound.
+ */
+
+// Which class to rebuild an entity as
+enum class EntityKind : uint8_t
+{
+    MARIO,
+    GOOMBA,
+    PIPE,
+    GROUND,
+    BREAKABLE_BLOCK,
+    ITEM_BLOCK,
+    BLOCK_SHARD,
+    MUSHROOM,
+    FIREFLOWER,
+    INVISIBLE_WALL,
+    FIREBALL,
+};
+
+struct AnimationState
+{
+    uint32_t remainingTicsThisFrame;
+    uint32_t spriteIndex;
+    // Only change when switching palettes
+    uint16_t xOffset;
+    uint16_t yOffset;
+    uint16_t width;
+    uint16_t height;
+};
+
+struct HitboxState
+{
+    sf::Vector2f size;
+    sf::Vector2f upperLeftOffset;
+    sf::Vector2f entityPosition;
+    bool isValid;
+};
+
+struct EntityState
+{
+    static const uint8_t MAX_ANIMATIONS = 8;
+    static const uint8_t NO_ANIMATION = 0xff;
+
+    uint32_t id;
+    EntityKind kind;
+
+    bool changingDirection;
+    bool cleanupFlag;
+    bool inputEnabled;
+    int32_t lookDirection;
+
+    sf::Vector2f position;
+    sf::Vector2f scale;
+    sf::IntRect textureRect;
+    sf::Vector2f velocity;
+    sf::Vector2f acceleration;
+    sf::Vector2f deltaP;
+    float maxVelocity;
+    uint16_t spriteWidth;
+    uint16_t spriteHeight;
+
+    HitboxState marioCollisionHitbox;
+    HitboxState spriteBoundsHitbox;
+
+    // Index into the subclass's animations, in the order it saves them
+    uint8_t activeAnimation;
+    uint8_t numAnimations;
+    AnimationState animations[MAX_ANIMATIONS];
+
+    // Subclass specific: the resting bottom of a Block, the top of the block
+    // an item emerges from, Mario's form and flags
+    float anchor;
+    uint32_t flags;
+    sf::IntRect frame;
+};
+
+static_assert(std::is_trivially_copyable_v<EntityState>,
+              "Entity states are copied as raw memory");
+
+struct TimedActionState
+{
+    double time;
+    EntityAction action;
+    uint32_t ownerId;
+    // Set when the action is a step of a script
+    const EntityScript* script;
+    uint32_t step;
+};
+
+struct StreamerState
+{
+    struct OpenTileRow
+    {
+        uint32_t row;
+        uint16_t nextTile;
+    };
+
+    // Record indices into the LevelFile
+    uint32_t nextSpawn;
+    uint32_t nextEnemy;
+    uint32_t nextTileRow;
+    std::vector<OpenTileRow> openTileRows;
+    float loadedUntil;
+};
+
+struct LevelState
+{
+    EntityState mario;
+    std::vector<EntityState> entities;
+
+    size_t numFrames;
+    std::vector<TimedActionState> timedActions;
+
+    size_t points;
+    sf::Vector2f cameraCenter;
+
+    bool hasStreamer;
+    StreamerState streamer;
+
+    // Approximate size in memory, for sizing a ring of snapshots
+    [[nodiscard]] size_t getNumBytes() const;
+};
+
+#endif  // SUPERMARIOBROS_SAVESTATE_H
@@ -0,0 +1,23 @@
+#include "SimulationContext.h"
+
+namespace
+{
+thread_local const SimulationContext* tContext = nullptr;
+}
+
+ScopedSimulationContext::ScopedSimulationContext(
+        const SimulationContext& context) :
+    mPrevious(tContext)
+{
+    tContext = &context;
+}
+
+ScopedSimulationContext::~ScopedSimulationContext()
+{
+    tContext = mPrevious;
+}
+
+const SimulationContext* getSimulationContext()
+{
+    return tContext;
+}
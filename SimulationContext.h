@@ -0,0 +1,40 @@
+#ifndef SUPERMARIOBROS_SIMULATIONCONTEXT_H
+#define SUPERMARIOBROS_SIMULATIONCONTEXT_H
+
+class EventBus;
+class JobSystem;
+class Timer;
+
+/*
+ * The Timer, EventBus and JobSystem a Level and its entities run against.
+ * getTimer(), getEventBus() and getJobSystem() return the ones of the
+ * calling thread's context while a ScopedSimulationContext is alive, and
+ * the global instances otherwise. This lets several Levels run side by
+ * side, each on its own thread, without sharing any of them.
+ */
+struct SimulationContext
+{
+    Timer* timer;
+    EventBus* eventBus;
+    JobSystem* jobSystem;
+};
+
+// Makes context the calling thread's until the scope ends
+class ScopedSimulationContext
+{
+public:
+    explicit ScopedSimulationContext(const SimulationContext& context);
+    ~ScopedSimulationContext();
+
+    ScopedSimulationContext(const ScopedSimulationContext&) = delete;
+    ScopedSimulationContext& operator=(const ScopedSimulationContext&) =
+            delete;
+
+private:
+    const SimulationContext* mPrevious;
+};
+
+// The calling thread's context, or null if it uses the global instances
+const SimulationContext* getSimulationContext();
+
+#endif  // SUPERMARIOBROS_SIMULATIONCONTEXT_H
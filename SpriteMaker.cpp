@@ -43,13 +43,23 @@ SpriteMaker::SpriteMaker(const std::string& resourcesDir)
     itemAndObjectTexture.setSmooth(false);
 }
 
+SpriteMaker::SpriteMaker() = default;
+
+namespace
+{
 std::unique_ptr<SpriteMaker> gSpriteMaker = nullptr;
+}
 
 void initializeSpriteMaker(const std::string& resourceDir)
 {
     gSpriteMaker = std::make_unique<SpriteMaker>(resourceDir);
 }
 
+void initializeHeadlessSpriteMaker()
+{
+    gSpriteMaker = std::make_unique<SpriteMaker>();
+}
+
 std::unique_ptr<SpriteMaker>& getSpriteMaker()
 {
     if (!gSpriteMaker)
@@ -11,6 +11,10 @@ class SpriteMaker
 public:
     explicit SpriteMaker(const std::string& resourcesDir);
 
+    // Leaves every texture empty, for running the simulation without a
+    // display (loading a texture needs an OpenGL context)
+    SpriteMaker();
+
     sf::Texture enemyTexture;
     sf::Texture playerTexture;
     sf::Texture blockTexture;
@@ -19,6 +23,7 @@ public:
 };
 
 void initializeSpriteMaker(const std::string& resourceDir);
+void initializeHeadlessSpriteMaker();
 std::unique_ptr<SpriteMaker>& getSpriteMaker();
 
 #endif  // SUPERMARIOBROS_SPRITEMAKER_H
@@ -34,9 +34,9 @@ void Text::updateString(const std::string& newString) {
     mSfText.setString(newString);
 }
 
-void Text::draw(sf::RenderWindow& window) const
+void Text::draw(sf::RenderTarget& target) const
 {
-    window.draw(mSfText);
+    target.draw(mSfText);
 }
 
 void Text::updatePosition(float deltaX, float deltaY)
@@ -56,6 +56,19 @@ void Points::addPoints(size_t newPoints) {
      updateString(formatPoints(mNumPoints));
 }
 
+size_t Points::getPoints() const
+{
+    return mNumPoints;
+}
+
+void Points::setPoints(size_t numPoints)
+{
+    if (numPoints == mNumPoints)
+        return;
+    mNumPoints = numPoints;
+    updateString(formatPoints(mNumPoints));
+}
+
 std::string Points::formatPoints(size_t numPoints)
 {
     auto stringValue = std::to_string(numPoints);
@@ -18,7 +18,7 @@ public:
 
     void updateString(const std::string& newString);
 
-    void draw(sf::RenderWindow& window) const;
+    void draw(sf::RenderTarget& target) const;
 
     void updatePosition(float deltaX, float deltaY);
 
@@ -33,6 +33,9 @@ public:
 
     void addPoints(size_t newPoints);
 
+    [[nodiscard]] size_t getPoints() const;
+    void setPoints(size_t numPoints);
+
 private:
     static std::string formatPoints(size_t numPoints);
 
@@ -1,7 +1,10 @@
 #include "Timer.h"
 
+#include <algorithm>
 #include <utility>
 
+#include "SimulationContext.h"
+
 namespace
 {
 Timer gTimer;
@@ -9,57 +12,171 @@ Timer gTimer;
 
 Timer& getTimer()
 {
+    if (const auto* context = getSimulationContext())
+        return *context->timer;
     return gTimer;
 }
 
 void Timer::scheduleSeconds(double numSeconds,
-                            const std::function<void()>& callback)
+                            const std::function<void()>& callback,
+                            const void* owner)
 {
     scheduledTimes.emplace_back(numFrames + numSeconds * FRAMES_PER_SECOND,
-                                callback);
+                                callback,
+                                owner);
+}
+
+void Timer::scheduleSeconds(double numSeconds,
+                            EntityAction action,
+                            Entity& owner)
+{
+    scheduledTimes.emplace_back(numFrames + numSeconds * FRAMES_PER_SECOND,
+                                action,
+                                owner);
+}
+
+void Timer::runScript(const EntityScript& script, Entity& owner)
+{
+    scheduledTimes.emplace_back(
+            numFrames + script.getStep(0).frames, script, 0, owner);
 }
 
 void Timer::scheduleEveryNSeconds(double numSeconds,
-                                  const std::function<void()>& callback)
+                                  const std::function<void()>& callback,
+                                  const void* owner)
 {
     repeatedTimes.emplace_back(numSeconds * FRAMES_PER_SECOND,
                                numFrames,
-                               callback);
+                               callback,
+                               owner);
+}
+
+void Timer::cancel(const void* owner)
+{
+    if (owner == nullptr)
+        return;
+
+    if (mIsFiring)
+    {
+        for (auto& event : scheduledTimes)
+            event.mIsDone = event.mIsDone || event.mOwner == owner;
+        for (auto& event : repeatedTimes)
+            event.mIsDone = event.mIsDone || event.mOwner == owner;
+        return;
+    }
+    scheduledTimes.erase(std::remove_if(scheduledTimes.begin(),
+                                        scheduledTimes.end(),
+                                        [owner](const ScheduledEvent& event)
+                                        { return event.mOwner == owner; }),
+                         scheduledTimes.end());
+    repeatedTimes.erase(std::remove_if(repeatedTimes.begin(),
+                                       repeatedTimes.end(),
+                                       [owner](const RecurringEvent& event)
+                                       { return event.mOwner == owner; }),
+                        repeatedTimes.end());
 }
 
 void Timer::incrementNumFrames()
 {
+    // Callbacks may schedule more, which only appends, and cancel, which
+    // only marks entries while mIsFiring is set, so i keeps pointing at the
+    // entry that fired
+    mIsFiring = true;
     for (int i = static_cast<int>(scheduledTimes.size() - 1); i >= 0; i--)
     {
-        ScheduledEvent event = scheduledTimes[i];
-        if (numFrames == event.mTime)
-        {
-            event.mCallback();
-            scheduledTimes.erase(scheduledTimes.begin() + i);
-        }
+        if (scheduledTimes[i].mIsDone || numFrames != scheduledTimes[i].mTime)
+            continue;
+        // Copied because firing may schedule more and reallocate
+        const auto event = scheduledTimes[i];
+        event.fire();
+        auto& fired = scheduledTimes[i];
+        if (!fired.mIsDone && !fired.advance())
+            fired.mIsDone = true;
     }
     for (int i = static_cast<int>(repeatedTimes.size() - 1); i >= 0; i--)
     {
         auto event = repeatedTimes[i];
-        if (numFrames == event.mTime + event.mStartingNumFrames)
+        if (!event.mIsDone &&
+            numFrames == event.mTime + event.mStartingNumFrames)
         {
             event.mCallback();
             repeatedTimes[i].mStartingNumFrames = numFrames;
         }
     }
+    mIsFiring = false;
+    removeDoneEvents();
     numFrames += 1;
 }
 
-ScheduledEvent::ScheduledEvent(size_t time, std::function<void()> callback) :
+void Timer::removeDoneEvents()
+{
+    scheduledTimes.erase(std::remove_if(scheduledTimes.begin(),
+                                        scheduledTimes.end(),
+                                        [](const ScheduledEvent& event)
+                                        { return event.mIsDone; }),
+                         scheduledTimes.end());
+    repeatedTimes.erase(std::remove_if(repeatedTimes.begin(),
+                                       repeatedTimes.end(),
+                                       [](const RecurringEvent& event)
+                                       { return event.mIsDone; }),
+                        repeatedTimes.end());
+}
+
+ScheduledEvent::ScheduledEvent(size_t time,
+                               std::function<void()> callback,
+                               const void* owner) :
     mTime(time),
-    mCallback(std::move(callback))
+    mCallback(std::move(callback)),
+    mOwner(owner)
 {
 }
+
+ScheduledEvent::ScheduledEvent(size_t time,
+                               EntityAction action,
+                               Entity& target) :
+    mTime(time),
+    mOwner(&target),
+    mAction(action),
+    mTarget(&target)
+{
+}
+
+ScheduledEvent::ScheduledEvent(size_t time,
+                               const EntityScript& script,
+                               size_t step,
+                               Entity& target) :
+    ScheduledEvent(time, script.getStep(step).action, target)
+{
+    mScript = &script;
+    mStep = step;
+}
+
+bool ScheduledEvent::advance()
+{
+    if (mScript == nullptr || mStep + 1 == mScript->getNumSteps())
+        return false;
+    ++mStep;
+    const auto& step = mScript->getStep(mStep);
+    mTime += step.frames;
+    mAction = step.action;
+    return true;
+}
+
+void ScheduledEvent::fire() const
+{
+    if (mAction)
+        mAction(*mTarget);
+    else
+        mCallback();
+}
+
 RecurringEvent::RecurringEvent(size_t time,
                                size_t startingNumFrames,
-                               std::function<void()> callback) :
+                               std::function<void()> callback,
+                               const void* owner) :
     mTime(time),
     mStartingNumFrames(startingNumFrames),
-    mCallback(std::move(callback))
+    mCallback(std::move(callback)),
+    mOwner(owner)
 {
 }
@@ -9,13 +9,89 @@
 #include <functional>
 #include <vector>
 
+class Entity;
+
+// Timed work on an entity. The entity is passed in rather than captured, so
+// a restored save state can point the action at a rebuilt entity.
+using EntityAction = void (*)(Entity& owner);
+
+struct ScriptStep
+{
+    // Frames to wait after the previous step, or after the script starts;
+    // at least one
+    size_t frames;
+    EntityAction action;
+};
+
+/*
+ * A fixed sequence of timed actions on one entity, e.g. a death animation
+ * followed by cleanup. Declare the steps as a static array and wrap them:
+ *
+ *     static const ScriptStep steps[] = {{15, &hop}, {30, &fall}};
+ *     static const EntityScript script(steps);
+ *
+ * A running script is a single Timer entry that moves on to the next step
+ * in place, so a sequence allocates nothing per step and cancelling the
+ * owner stops it wherever it is.
+ */
+class EntityScript
+{
+public:
+    template <size_t N>
+    constexpr explicit EntityScript(const ScriptStep (&steps)[N]) :
+        mSteps(steps),
+        mNumSteps(N)
+    {
+    }
+
+    [[nodiscard]] const ScriptStep& getStep(size_t step) const
+    {
+        return mSteps[step];
+    }
+
+    [[nodiscard]] size_t getNumSteps() const
+    {
+        return mNumSteps;
+    }
+
+private:
+    const ScriptStep* mSteps;
+    size_t mNumSteps;
+};
+
 class ScheduledEvent
 {
 public:
     double mTime;
     std::function<void()> mCallback;
+    const void* mOwner;
+
+    // Set instead of mCallback for entity actions; mOwner is then the target
+    EntityAction mAction = nullptr;
+    Entity* mTarget = nullptr;
+
+    ScheduledEvent(size_t time,
+                   std::function<void()> callback,
+                   const void* owner);
+    ScheduledEvent(size_t time, EntityAction action, Entity& target);
+
+    // Set, along with mAction and mTarget, for the current step of a script
+    const EntityScript* mScript = nullptr;
+    size_t mStep = 0;
+
+    // Finished or cancelled while the timer was firing; removed once it is
+    // done, so that the entries it is walking through stay where they are
+    bool mIsDone = false;
 
-    ScheduledEvent(size_t time, std::function<void()> callback);
+    ScheduledEvent(size_t time,
+                   const EntityScript& script,
+                   size_t step,
+                   Entity& target);
+
+    void fire() const;
+
+    // Move a script on to its next step. Returns false after the last one.
+    bool advance();
 };
 
 class RecurringEvent
@@ -24,15 +100,34 @@ public:
     double mTime;
     double mStartingNumFrames;
     std::function<void()> mCallback;
+    const void* mOwner;
+
+    // Cancelled while the timer was firing, as for ScheduledEvent
+    bool mIsDone = false;
 
-    RecurringEvent(size_t time, size_t startingNumFrames, std::function<void()> callback);
+    RecurringEvent(size_t time,
+                   size_t startingNumFrames,
+                   std::function<void()> callback,
+                   const void* owner);
 };
 
 class Timer
 {
 public:
-    void scheduleSeconds(double numSeconds, const std::function<void()>& callback);
-    void scheduleEveryNSeconds(double numSeconds, const std::function<void()>& callback);
+    // The optional owner lets every callback that refers to an object be
+    // cancelled together when that object goes away
+    void scheduleSeconds(double numSeconds,
+                         const std::function<void()>& callback,
+                         const void* owner = nullptr);
+    void scheduleEveryNSeconds(double numSeconds,
+                               const std::function<void()>& callback,
+                               const void* owner = nullptr);
+    void scheduleSeconds(double numSeconds,
+                         EntityAction action,
+                         Entity& owner);
+    void runScript(const EntityScript& script, Entity& owner);
+    // Safe to call from a firing callback, including for its own owner
+    void cancel(const void* owner);
     void incrementNumFrames();
 
     size_t numFrames;
@@ -40,8 +135,14 @@ public:
     std::vector<RecurringEvent> repeatedTimes;
 
     const size_t FRAMES_PER_SECOND = 30;
+
+private:
+    void removeDoneEvents();
+
+    bool mIsFiring = false;
 };
 
+// The calling thread's SimulationContext's, if it has one
 Timer& getTimer();
 
 
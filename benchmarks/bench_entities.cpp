@@ -0,0 +1,155 @@
+#include <entities/Fireball.h>
+#include <entities/Goomba.h>
+#include <entities/Ground.h>
+#include <entities/Items.h>
+#include <entities/Mario.h>
+
+#include "SpriteMaker.h"
+#include "bench_util.h"
+
+namespace
+{
+// Reaches Entity::handleCollision, which is protected, on any entity
+class CollisionResponse : public Entity
+{
+public:
+    static void handle(Entity& entity, const Collision& collision, Entity& other)
+    {
+        (entity.*(&CollisionResponse::handleCollision))(collision, other);
+    }
+};
+
+std::vector<Hitbox> makeHitboxRow(size_t count)
+{
+    std::vector<Hitbox> hitboxes(count, Hitbox({16, 16}, {0, 0}));
+    for (size_t ii = 0; ii < count; ++ii)
+        hitboxes[ii].setEntityPosition({ii * 16.f, 132});
+    return hitboxes;
+}
+}
+
+static void BM_HitboxCollidesWith(benchmark::State& state)
+{
+    const auto hitboxes = makeHitboxRow(state.range(0));
+    Hitbox probe({16, 16}, {0, 0});
+    probe.setEntityPosition({40, 130});
+
+    for (auto _ : state)
+    {
+        size_t numCollisions = 0;
+        for (const auto& hitbox : hitboxes)
+            numCollisions += probe.collidesWith(hitbox);
+        benchmark::DoNotOptimize(numCollisions);
+    }
+    state.SetItemsProcessed(state.iterations() * hitboxes.size());
+}
+BENCHMARK(BM_HitboxCollidesWith)->Apply(entityCounts);
+
+static void BM_EntityDetectCollision(benchmark::State& state)
+{
+    const auto& sprites = *getSpriteMaker();
+    std::vector<std::unique_ptr<Ground>> tiles;
+    for (int64_t ii = 0; ii < state.range(0); ++ii)
+    {
+        tiles.push_back(std::make_unique<Ground>(
+                sprites.inanimateObjectTexture, sf::Vector2f(ii * 16.f, 132)));
+    }
+    Ground probe(sprites.inanimateObjectTexture, sf::Vector2f(40, 120));
+    probe.mDeltaP = {1, 4};
+
+    // Projected once per frame, as Level does
+    const auto probeHitboxes = probe.projectHitboxes();
+    std::vector<ProjectedHitboxes> tileHitboxes;
+    for (const auto& tile : tiles)
+        tileHitboxes.push_back(tile->projectHitboxes());
+
+    for (auto _ : state)
+    {
+        // Detection, then the response, as Level runs them. Ground ignores
+        // the outcome, so repeated runs see the same state.
+        size_t numCollisions = 0;
+        for (size_t ii = 0; ii < tiles.size(); ++ii)
+        {
+            CollisionRecord record;
+            if (!probe.findCollision(
+                    *tiles[ii], probeHitboxes, tileHitboxes[ii], record))
+                continue;
+            Entity::resolveCollision(record);
+            ++numCollisions;
+        }
+        benchmark::DoNotOptimize(numCollisions);
+    }
+    state.SetItemsProcessed(state.iterations() * tiles.size());
+}
+BENCHMARK(BM_EntityDetectCollision)->Apply(entityCounts);
+
+static void BM_EntityUpdatePosition(benchmark::State& state)
+{
+    const auto& sprites = *getSpriteMaker();
+    std::vector<std::unique_ptr<Entity>> goombas;
+    for (int64_t ii = 0; ii < state.range(0); ++ii)
+    {
+        goombas.push_back(std::make_unique<Goomba>(
+                sprites.enemyTexture, sf::Vector2f(ii * 16.f, 100)));
+    }
+
+    for (auto _ : state)
+    {
+        for (auto& goomba : goombas)
+            goomba->updatePosition();
+    }
+    state.SetItemsProcessed(state.iterations() * goombas.size());
+}
+BENCHMARK(BM_EntityUpdatePosition)->Apply(entityCounts);
+
+// Movers of every kind landing on the ground, which is the bulk of the
+// collisions in a frame. Landing again on the same tile changes nothing, so
+// every iteration does the same work.
+static void BM_CollisionResponse(benchmark::State& state)
+{
+    const auto& sprites = *getSpriteMaker();
+    std::vector<std::unique_ptr<Entity>> movers;
+    std::vector<std::unique_ptr<Entity>> tiles;
+    for (int64_t ii = 0; ii < state.range(0); ++ii)
+    {
+        const sf::Vector2f position(ii * 16.f, 100);
+        switch (ii % 4)
+        {
+        case 0:
+            movers.push_back(
+                    std::make_unique<Goomba>(sprites.enemyTexture, position));
+            break;
+        case 1:
+            movers.push_back(std::make_unique<Mushroom>(
+                    sprites.itemAndObjectTexture, position, 0.f));
+            break;
+        case 2:
+            movers.push_back(std::make_unique<Fireball>(
+                    sprites.itemAndObjectTexture, position, 1));
+            break;
+        default:
+            movers.push_back(
+                    std::make_unique<Mario>(sprites.playerTexture, position));
+            break;
+        }
+        tiles.push_back(std::make_unique<Ground>(
+                sprites.inanimateObjectTexture,
+                sf::Vector2f(position.x, 132)));
+    }
+
+    for (auto _ : state)
+    {
+        for (size_t ii = 0; ii < movers.size(); ++ii)
+        {
+            CollisionResponse::handle(
+                    *movers[ii],
+                    Collision{tiles[ii].get(),
+                              EntitySide::BOTTOM,
+                              tiles[ii]->getTop(),
+                              0},
+                    *tiles[ii]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * movers.size());
+}
+BENCHMARK(BM_CollisionResponse)->Apply(entityCounts);
@@ -0,0 +1,127 @@
+#include <limits>
+
+#include "EventBus.h"
+#include "LevelBatch.h"
+#include "LevelGenerator.h"
+#include "bench_util.h"
+
+static void BM_LevelExecuteFrame(benchmark::State& state)
+{
+    auto level = makeSyntheticLevel(state.range(0));
+    for (auto _ : state)
+        level->executeFrame({});
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LevelExecuteFrame)->Apply(entityCounts);
+
+// Every entity inside the activity window, so collisions are all-pairs.
+// Stops at 1k; 100k entities would take minutes per frame.
+static void BM_LevelExecuteFrameAllActive(benchmark::State& state)
+{
+    auto level = makeSyntheticLevel(state.range(0));
+    level->setActivityMargin(std::numeric_limits<float>::infinity());
+    for (auto _ : state)
+        level->executeFrame({});
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LevelExecuteFrameAllActive)->RangeMultiplier(10)->Range(10, 1000);
+
+// Nothing but scenery in the activity window, all of it asleep
+static void BM_LevelExecuteFrameIdle(benchmark::State& state)
+{
+    auto options = stressLevelOptions(state.range(0));
+    options.numGoombaSwarms = 0;
+    auto level = generateLevel(options);
+    level->setActivityMargin(std::numeric_limits<float>::infinity());
+    for (auto _ : state)
+        level->executeFrame({});
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LevelExecuteFrameIdle)->RangeMultiplier(10)->Range(10, 10000);
+
+static void BM_EventDispatch(benchmark::State& state)
+{
+    auto level = makeSyntheticLevel(10);
+    const auto numEvents = state.range(0);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (int64_t ii = 0; ii < numEvents; ++ii)
+            publishEvent(Event::PointsEarned{{0, 0}, 0});
+        state.ResumeTiming();
+
+        level->executeFrame({});
+    }
+    state.SetItemsProcessed(state.iterations() * numEvents);
+}
+BENCHMARK(BM_EventDispatch)->Apply(entityCounts);
+
+static void BM_DrawFrameOffscreen(benchmark::State& state)
+{
+    auto level = makeSyntheticLevel(state.range(0));
+    sf::RenderTexture target;
+    if (!target.create(200, 200))
+    {
+        state.SkipWithError("Unable to create render texture");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        level->drawFrame(target);
+        target.display();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DrawFrameOffscreen)->Apply(entityCounts);
+
+// A generated level of N columns with every entity resident, so frame time
+// can be plotted against the length of a level
+static void BM_GeneratedLevelExecuteFrame(benchmark::State& state)
+{
+    auto level = generateLevel(stressLevelOptions(state.range(0)));
+    for (auto _ : state)
+        level->executeFrame({});
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GeneratedLevelExecuteFrame)->Apply(entityCounts);
+
+// A 16x15 grid of the screen; should not grow with the length of the level
+static void BM_WriteObservation(benchmark::State& state)
+{
+    auto level = makeSyntheticLevel(state.range(0));
+    level->executeFrame({});
+    std::vector<uint8_t> cells(16 * 15);
+    for (auto _ : state)
+    {
+        level->writeObservation(cells.data(), 16, 15);
+        benchmark::DoNotOptimize(cells.data());
+    }
+    state.SetItemsProcessed(state.iterations() * cells.size());
+}
+BENCHMARK(BM_WriteObservation)->Apply(entityCounts);
+
+// Environment steps per second across N synthetic levels of 100 entities,
+// with Mario running right in each and starting over when he dies. Every
+// step also produces each instance's observation, as an agent would need.
+static void BM_LevelBatchStep(benchmark::State& state)
+{
+    const auto numInstances = static_cast<size_t>(state.range(0));
+    LevelBatch batch(numInstances, [] { return makeSyntheticLevel(100); });
+    std::vector<KeyboardInput> inputs(numInstances);
+    for (auto& input : inputs)
+        input.right.keyIsDown = true;
+    std::vector<uint8_t> observations(numInstances * 16 * 15);
+    for (auto _ : state)
+    {
+        batch.step(inputs);
+        batch.writeObservations(observations.data(), 16, 15);
+        for (size_t ii = 0; ii < numInstances; ++ii)
+        {
+            if (batch.getDone()[ii])
+                batch.reset(ii);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LevelBatchStep)->RangeMultiplier(4)->Range(1, 64);
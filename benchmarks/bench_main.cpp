@@ -0,0 +1,19 @@
+#include <benchmark/benchmark.h>
+#include <file_util.h>
+
+#include "SpriteMaker.h"
+#include "Text.h"
+
+int main(int argc, char** argv)
+{
+    // Textures stay empty so the benchmarks need no display
+    initializeHeadlessSpriteMaker();
+    initializeHUDOverlay(findRootDirectory(argv[0]) + "resources/");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
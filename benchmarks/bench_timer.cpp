@@ -0,0 +1,19 @@
+#include "Timer.h"
+#include "bench_util.h"
+
+// Pending events that never come due, so every frame only pays for
+// scanning them
+static void BM_TimerIncrementNumFrames(benchmark::State& state)
+{
+    Timer timer;
+    timer.numFrames = 0;
+    int counter = 0;
+    for (int64_t ii = 0; ii < state.range(0); ++ii)
+        timer.scheduleSeconds(1e9, [&counter]() { ++counter; });
+
+    for (auto _ : state)
+        timer.incrementNumFrames();
+    benchmark::DoNotOptimize(counter);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimerIncrementNumFrames)->Apply(entityCounts);
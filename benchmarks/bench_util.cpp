@@ -0,0 +1,55 @@
+#include "bench_util.h"
+
+#include <entities/Goomba.h>
+#include <entities/Ground.h>
+
+#include "SpriteMaker.h"
+
+void entityCounts(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(10)->Range(10, 100000);
+}
+
+std::vector<std::unique_ptr<Entity>> makeSyntheticEntities(size_t count)
+{
+    const auto& sprites = *getSpriteMaker();
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.reserve(count);
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        const auto x = static_cast<float>(ii * GRIDBOX_SIZE);
+        // The tile under a Goomba is left out, which makes a pit now and then
+        if (ii % 8 == 7)
+            entities.push_back(std::make_unique<Goomba>(
+                    sprites.enemyTexture,
+                    sf::Vector2f(x - 4 * GRIDBOX_SIZE, 100)));
+        else
+            entities.push_back(std::make_unique<Ground>(
+                    sprites.inanimateObjectTexture, sf::Vector2f(x, 132)));
+    }
+    return entities;
+}
+
+std::unique_ptr<Level> makeSyntheticLevel(size_t numEntities)
+{
+    auto mario = std::make_unique<Mario>(getSpriteMaker()->playerTexture,
+                                         sf::Vector2f(32, 100));
+    return std::make_unique<Level>(std::move(mario),
+                                   makeSyntheticEntities(numEntities));
+}
+
+LevelGeneratorOptions stressLevelOptions(size_t numColumns)
+{
+    const LevelGeneratorOptions defaults;
+    const auto scale = [&](size_t count)
+    {
+        return count * numColumns / defaults.numColumns;
+    };
+
+    auto options = defaults;
+    options.numColumns = numColumns;
+    options.numPipes = scale(defaults.numPipes);
+    options.numBlockRows = scale(defaults.numBlockRows);
+    options.numGoombaSwarms = scale(defaults.numGoombaSwarms);
+    return options;
+}
@@ -0,0 +1,27 @@
+#ifndef SUPERMARIOBROS_BENCH_UTIL_H
+#define SUPERMARIOBROS_BENCH_UTIL_H
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "Level.h"
+#include "LevelGenerator.h"
+
+// Sweep 10, 100, ... 100k entities
+void entityCounts(benchmark::internal::Benchmark* benchmark);
+
+/*
+ * A flat floor of ground tiles with a Goomba on every eighth tile, starting
+ * at x = 0. Only the first dozen or so tiles are on screen.
+ */
+std::vector<std::unique_ptr<Entity>> makeSyntheticEntities(size_t count);
+
+std::unique_ptr<Level> makeSyntheticLevel(size_t numEntities);
+
+// Generator options for a level numColumns long with the default density of
+// pipes, blocks and Goombas
+LevelGeneratorOptions stressLevelOptions(size_t numColumns);
+
+#endif  // SUPERMARIOBROS_BENCH_UTIL_H
@@ -1,14 +1,12 @@
 #include "Block.h"
 
 #include <AnimationBuilder.h>
+#include <SaveState.h>
 #include <SpriteMaker.h>
 #include <Timer.h>
 
-#include <cassert>
-
-#include "Event.h"
+#include "EventBus.h"
 #include "Items.h"
-#include "Mario.h"
 
 Block::Block(const sf::Texture& texture, const sf::Vector2f& position) :
     Entity(texture,
@@ -40,24 +38,35 @@ BreakableBlock::BreakableBlock(const sf::Texture& texture,
             AnimationBuilder().withOffset(16, 0).withRectSize(16, 16).build(
                     mActiveSprite);
     mActiveAnimation = &defaultAnimation;
+    setCollisionHandlers(collisionHandlers());
 }
 
-void BreakableBlock::onCollision(const Collision& collision)
+const CollisionHandlers& BreakableBlock::collisionHandlers()
+{
+    static constexpr auto handlers = makeCollisionHandlers({
+            {EntityType::SMALL_MARIO, &BreakableBlock::onSmallMario},
+            {isMario, &BreakableBlock::onBigMario},
+    });
+    static_assert(agreesWithCollisionMatrix(handlers, EntityType::BLOCK),
+                  "BreakableBlock's handlers disagree with "
+                  "respondsToCollision()");
+    return handlers;
+}
+
+void BreakableBlock::onSmallMario(Entity& self, const Collision& collision)
+{
+    if (collision.side == EntitySide::BOTTOM)
+        static_cast<BreakableBlock&>(self).bumpUp();
+}
+
+void BreakableBlock::onBigMario(Entity& self, const Collision& collision)
 {
-    if (!isMario(collision.entity->getType()))
-        return;
     if (collision.side != EntitySide::BOTTOM)
         return;
-    if (collision.entity->getType() == EntityType::SMALL_MARIO)
-    {
-        bumpUp();
-    }
-    else
-    {
-        this->setCleanupFlag();
-        dispatchEvent(Event::constructBlockShattered({getLeft(), getTop()}));
-        dispatchEvent(Event::constructPointsEarned({getTop(), getLeft()}, 50));
-    }
+    auto& block = static_cast<BreakableBlock&>(self);
+    block.setCleanupFlag();
+    publishEvent(Event::BlockShattered{{block.getLeft(), block.getTop()}});
+    publishEvent(Event::PointsEarned{{block.getTop(), block.getLeft()}, 50});
 }
 
 ItemBlock::ItemBlock(const sf::Texture& texture, const sf::Vector2f& position) :
@@ -77,32 +86,40 @@ ItemBlock::ItemBlock(const sf::Texture& texture, const sf::Vector2f& position) :
                     mActiveSprite);
 
     mActiveAnimation = &hasItemAnimation;
+    setCollisionHandlers(collisionHandlers());
 }
 
-void ItemBlock::onCollision(const Collision& collision)
+const CollisionHandlers& ItemBlock::collisionHandlers()
+{
+    static constexpr auto handlers = makeCollisionHandlers({
+            {EntityType::SMALL_MARIO, &ItemBlock::onSmallMario},
+            {isMario, &ItemBlock::onBigMario},
+    });
+    static_assert(agreesWithCollisionMatrix(handlers, EntityType::BLOCK),
+                  "ItemBlock's handlers disagree with respondsToCollision()");
+    return handlers;
+}
+
+void ItemBlock::onSmallMario(Entity& self, const Collision& collision)
+{
+    if (collision.side == EntitySide::BOTTOM)
+        static_cast<ItemBlock&>(self).spawnItem(EntityType::MUSHROOM);
+}
+
+void ItemBlock::onBigMario(Entity& self, const Collision& collision)
+{
+    if (collision.side == EntitySide::BOTTOM)
+        static_cast<ItemBlock&>(self).spawnItem(EntityType::FIREFLOWER);
+}
+
+void ItemBlock::spawnItem(EntityType item)
 {
-    if (!isMario(collision.entity->getType()))
-        return;
-    if (collision.side != EntitySide::BOTTOM)
-        return;
     if (mActiveAnimation == &noItemAnimation)
         return;
 
     bumpUp();
-
-    auto* mario = reinterpret_cast<Mario*>(collision.entity);
-    assert(mario != nullptr);
-
-    if (mario->getForm() == MarioForm::SMALL_MARIO)
-        dispatchEvent(Event::constructItemSpawned(EntityType::MUSHROOM,
-                                                  sf::Vector2f(getLeft(),
-                                                               getBottom() - 5),
-                                                  getTop()));
-    else
-        dispatchEvent(Event::constructItemSpawned(EntityType::FIREFLOWER,
-                                                  sf::Vector2f(getLeft(),
-                                                               getBottom() - 5),
-                                                  getTop()));
+    publishEvent(Event::ItemSpawned{
+            sf::Vector2f(getLeft(), getBottom() - 5), item, getTop()});
     mActiveAnimation = &noItemAnimation;
 }
 
@@ -134,5 +151,57 @@ BlockShard::BlockShard(const sf::Texture& texture,
                                .build(mActiveSprite);
     mActiveAnimation = &defaultAnimation;
 
-    getTimer().scheduleSeconds(10, [&]() { this->setCleanupFlag(); });
+    getTimer().scheduleSeconds(
+            10, [](Entity& owner) { owner.setCleanupFlag(); }, *this);
+}
+
+void Block::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.anchor = mOriginalBottom;
+}
+
+void Block::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    mOriginalBottom = state.anchor;
+}
+
+void BreakableBlock::saveState(EntityState& state) const
+{
+    Block::saveState(state);
+    state.kind = EntityKind::BREAKABLE_BLOCK;
+    saveAnimations(state, {&defaultAnimation});
+}
+
+void BreakableBlock::restoreState(const EntityState& state)
+{
+    Block::restoreState(state);
+    restoreAnimations(state, {&defaultAnimation});
+}
+
+void ItemBlock::saveState(EntityState& state) const
+{
+    Block::saveState(state);
+    state.kind = EntityKind::ITEM_BLOCK;
+    saveAnimations(state, {&hasItemAnimation, &noItemAnimation});
+}
+
+void ItemBlock::restoreState(const EntityState& state)
+{
+    Block::restoreState(state);
+    restoreAnimations(state, {&hasItemAnimation, &noItemAnimation});
+}
+
+void BlockShard::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::BLOCK_SHARD;
+    saveAnimations(state, {&defaultAnimation});
+}
+
+void BlockShard::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    restoreAnimations(state, {&defaultAnimation});
 }
@@ -8,13 +8,15 @@ class Block : public Entity
 public:
     Block(const sf::Texture& texture, const sf::Vector2f& position);
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
 protected:
     void doInternalCalculations() override;
 
     void bumpUp();
 
-    const float
-            mOriginalBottom;  // Record initial position so we can detect when
+    float mOriginalBottom;  // Record initial position so we can detect when
     // "bump" is over
 };
 
@@ -23,10 +25,14 @@ class BreakableBlock : public Block
 public:
     BreakableBlock(const sf::Texture& texture, const sf::Vector2f& position);
 
-protected:
-    void onCollision(const Collision& collision) override;
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
 
 private:
+    static const CollisionHandlers& collisionHandlers();
+    static void onSmallMario(Entity& self, const Collision& collision);
+    static void onBigMario(Entity& self, const Collision& collision);
+
     Animation defaultAnimation;
 };
 
@@ -35,10 +41,17 @@ class ItemBlock : public Block
 public:
     ItemBlock(const sf::Texture& texture, const sf::Vector2f& position);
 
-protected:
-    void onCollision(const Collision& collision) override;
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
 
 private:
+    static const CollisionHandlers& collisionHandlers();
+    static void onSmallMario(Entity& self, const Collision& collision);
+    static void onBigMario(Entity& self, const Collision& collision);
+
+    // Spawns the item a Mario in the given form gets out of the block
+    void spawnItem(EntityType item);
+
     Animation hasItemAnimation;
     Animation noItemAnimation;
 };
@@ -51,6 +64,9 @@ public:
                const sf::Vector2f& fragmentOffset,
                const sf::Vector2f& initialVelocity);
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
     Animation defaultAnimation;
 };
 
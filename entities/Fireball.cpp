@@ -1,6 +1,7 @@
 #include "Fireball.h"
 
 #include <AnimationBuilder.h>
+#include <SaveState.h>
 #include <Timer.h>
 #include <iostream>
 
@@ -23,35 +24,44 @@ Fireball::Fireball(const sf::Texture& texture, const sf::Vector2f& position, int
     std::vector<sf::IntRect> spinningAnimation = {topLeftRect, topRightRect, bottomLeftRect, bottomRightRect};
     defaultAnimation = AnimationBuilder().withNonContiguousRect(spinningAnimation).andRepeat().build(mActiveSprite);
     mActiveAnimation = &defaultAnimation;
+    setCollisionHandlers(collisionHandlers());
 }
 
-void Fireball::onCollision(const Collision& collision)
+const CollisionHandlers& Fireball::collisionHandlers()
 {
-    EntityType entityType = collision.entity->getType();
-    if (isEnemy(entityType))
+    static constexpr auto handlers = makeCollisionHandlers({
+            {isEnemy, &Fireball::onEnemy},
+            {isObject, &Fireball::onObject},
+    });
+    static_assert(agreesWithCollisionMatrix(handlers, EntityType::FIREBALL),
+                  "Fireball's handlers disagree with respondsToCollision()");
+    return handlers;
+}
+
+void Fireball::onEnemy(Entity& self, const Collision&)
+{
+    static_cast<Fireball&>(self).terminate();
+}
+
+void Fireball::onObject(Entity& self, const Collision& collision)
+{
+    auto& fireball = static_cast<Fireball&>(self);
+    const auto hitbox = fireball.mSpriteBoundsHitbox;
+    const float yVelocityOnBounce = 5.f;
+    if (collision.side == EntitySide::LEFT || collision.side == EntitySide::RIGHT)
     {
-        terminate();
+        fireball.terminate();
     }
-    else if (isObject(entityType))
+    else if (collision.side == EntitySide::BOTTOM)
     {
-        const auto hitbox = getHitbox(collision.entity->getType());
-        const float yVelocityOnBounce = 5.f;
-        if (collision.side == EntitySide::LEFT || collision.side == EntitySide::RIGHT)
-        {
-            terminate();
-        }
-        else if (collision.side == EntitySide::BOTTOM)
-        {
-            clampY(hitbox.getBottom(), collision.yIntersection);
-            mVelocity.y = -yVelocityOnBounce;
-        }
-        else if (collision.side == EntitySide::TOP)
-        {
-            clampY(hitbox.getTop(), collision.yIntersection);
-            mVelocity.y = yVelocityOnBounce;
-        }
+        fireball.clampY(hitbox.getBottom(), collision.yIntersection);
+        fireball.mVelocity.y = -yVelocityOnBounce;
+    }
+    else if (collision.side == EntitySide::TOP)
+    {
+        fireball.clampY(hitbox.getTop(), collision.yIntersection);
+        fireball.mVelocity.y = yVelocityOnBounce;
     }
-
 }
 
 void Fireball::terminate()
@@ -65,5 +75,19 @@ void Fireball::terminate()
     mMarioCollisionHitbox.invalidate();
     mSpriteBoundsHitbox.invalidate();
 
-    getTimer().scheduleSeconds(0.1, [&]() { this->setCleanupFlag(); });
+    getTimer().scheduleSeconds(
+            0.1, [](Entity& owner) { owner.setCleanupFlag(); }, *this);
+}
+
+void Fireball::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::FIREBALL;
+    saveAnimations(state, {&deathAnimation, &defaultAnimation});
+}
+
+void Fireball::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    restoreAnimations(state, {&deathAnimation, &defaultAnimation});
 }
@@ -10,12 +10,17 @@ public:
 
     static float width() { return 8; }
 
-protected:
-    void onCollision(const Collision& collision) override;
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
 
+protected:
     void terminate() override;
 
 private:
+    static const CollisionHandlers& collisionHandlers();
+    static void onEnemy(Entity& self, const Collision& collision);
+    static void onObject(Entity& self, const Collision& collision);
+
     Animation deathAnimation;
     Animation defaultAnimation;
 };
@@ -1,7 +1,8 @@
 #include "Goomba.h"
 
 #include "AnimationBuilder.h"
-#include "Event.h"
+#include "EventBus.h"
+#include "SaveState.h"
 #include "Timer.h"
 
 Goomba::Goomba(const sf::Texture& texture, const sf::Vector2f& position) :
@@ -27,39 +28,56 @@ Goomba::Goomba(const sf::Texture& texture, const sf::Vector2f& position) :
                                .build(mActiveSprite);
 
     mActiveAnimation = &walkingAnimation;
+    setCollisionHandlers(collisionHandlers());
 }
 
-void Goomba::onCollision(const Collision& collision)
+const CollisionHandlers& Goomba::collisionHandlers()
 {
-    const auto hitbox = getHitbox(collision.entity->getType());
+    static constexpr auto handlers = makeCollisionHandlers({
+            {isMario, &Goomba::onMario},
+            {EntityType::FIREBALL, &Goomba::onFireball},
+            {isObject, &Goomba::onObject},
+    });
+    static_assert(agreesWithCollisionMatrix(handlers, EntityType::GOOMBA),
+                  "Goomba's handlers disagree with respondsToCollision()");
+    return handlers;
+}
+
+void Goomba::onMario(Entity& self, const Collision& collision)
+{
+    if (collision.side == EntitySide::TOP)
+        static_cast<Goomba&>(self).squash();
+}
+
+void Goomba::onFireball(Entity& self, const Collision&)
+{
+    static_cast<Goomba&>(self).squash();
+}
 
-    EntityType entityType = collision.entity->getType();
-    if ((isMario(entityType) &&
-        collision.side == EntitySide::TOP) || entityType == EntityType::FIREBALL)
+void Goomba::onObject(Entity& self, const Collision& collision)
+{
+    auto& goomba = static_cast<Goomba&>(self);
+    const auto& hitbox = goomba.mSpriteBoundsHitbox;
+    if (collision.side == EntitySide::BOTTOM)
+    {
+        goomba.clampY(hitbox.getBottom(), collision.yIntersection);
+    }
+    else if (collision.side == EntitySide::RIGHT)
     {
-        dispatchEvent(Event::constructPointsEarned({getTop(), getLeft()}, 100));
-        terminate();
+        goomba.clampX(hitbox.getRight(), collision.xIntersection);
     }
-    else
+    else if (collision.side == EntitySide::LEFT)
     {
-        if (isObject(collision.entity->getType()))
-        {
-            if (collision.side == EntitySide::BOTTOM)
-            {
-                clampY(hitbox.getBottom(), collision.yIntersection);
-            }
-            else if (collision.side == EntitySide::RIGHT)
-            {
-                clampX(hitbox.getRight(), collision.xIntersection);
-            }
-            else if (collision.side == EntitySide::LEFT)
-            {
-                clampX(hitbox.getLeft(), collision.xIntersection);
-            }
-        }
+        goomba.clampX(hitbox.getLeft(), collision.xIntersection);
     }
 }
 
+void Goomba::squash()
+{
+    publishEvent(Event::PointsEarned{{getTop(), getLeft()}, 100});
+    terminate();
+}
+
 void Goomba::terminate()
 {
     mActiveAnimation = &deathAnimation;
@@ -71,5 +89,23 @@ void Goomba::terminate()
     mMarioCollisionHitbox.invalidate();
     mSpriteBoundsHitbox.invalidate();
 
-    getTimer().scheduleSeconds(1, [&]() { this->setCleanupFlag(); });
+    // Leave the squashed Goomba on screen for a second
+    static const ScriptStep steps[] = {
+            {30, [](Entity& owner) { owner.setCleanupFlag(); }},
+    };
+    static const EntityScript squashed(steps);
+    getTimer().runScript(squashed, *this);
+}
+
+void Goomba::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::GOOMBA;
+    saveAnimations(state, {&walkingAnimation, &deathAnimation});
+}
+
+void Goomba::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    restoreAnimations(state, {&walkingAnimation, &deathAnimation});
 }
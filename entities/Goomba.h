@@ -14,8 +14,16 @@ public:
 
     void terminate() override;
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
 private:
-    void onCollision(const Collision& collision) override;
+    static const CollisionHandlers& collisionHandlers();
+    static void onMario(Entity& self, const Collision& collision);
+    static void onFireball(Entity& self, const Collision& collision);
+    static void onObject(Entity& self, const Collision& collision);
+
+    void squash();
 
     Animation walkingAnimation;
     Animation deathAnimation;
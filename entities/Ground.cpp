@@ -1,6 +1,7 @@
 #include "Ground.h"
 
 #include <AnimationBuilder.h>
+#include <SaveState.h>
 
 Ground::Ground(const sf::Texture& texture, const sf::Vector2f& position) :
     Entity(texture,
@@ -16,4 +17,17 @@ Ground::Ground(const sf::Texture& texture, const sf::Vector2f& position) :
             AnimationBuilder().withOffset(0, 0).withRectSize(16, 16).build(
                     mActiveSprite);
     mActiveAnimation = &defaultAnimation;
-}
\ No newline at end of file
+}
+
+void Ground::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::GROUND;
+    saveAnimations(state, {&defaultAnimation});
+}
+
+void Ground::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    restoreAnimations(state, {&defaultAnimation});
+}
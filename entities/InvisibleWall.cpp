@@ -1,5 +1,7 @@
 #include "InvisibleWall.h"
 
+#include "SaveState.h"
+
 InvisibleWall::InvisibleWall(const sf::Texture& texture,
                              const sf::Vector2f& position) :
     Entity(texture,
@@ -12,6 +14,12 @@ InvisibleWall::InvisibleWall(const sf::Texture& texture,
     mAcceleration = {0, 0};
 }
 
-void InvisibleWall::draw(sf::RenderWindow&)
+void InvisibleWall::draw(sf::RenderTarget&)
+{
+}
+
+void InvisibleWall::saveState(EntityState& state) const
 {
+    Entity::saveState(state);
+    state.kind = EntityKind::INVISIBLE_WALL;
 }
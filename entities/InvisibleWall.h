@@ -8,7 +8,9 @@ class InvisibleWall : public Entity
 public:
     InvisibleWall(const sf::Texture& texture, const sf::Vector2f& position);
 
-    void draw(sf::RenderWindow& window) override;
+    void draw(sf::RenderTarget& target) override;
+
+    void saveState(EntityState& state) const override;
 
 private:
     // Needed to make parent ctor happy
@@ -1,6 +1,8 @@
 #include "Items.h"
 
 #include <AnimationBuilder.h>
+#include <EventBus.h>
+#include <SaveState.h>
 
 Fireflower::Fireflower(const sf::Texture& texture,
                        const sf::Vector2f& position,
@@ -26,6 +28,16 @@ Fireflower::Fireflower(const sf::Texture& texture,
                                .andRepeat()
                                .build(mActiveSprite);
     mActiveAnimation = &defaultAnimation;
+    setCollisionHandlers(collisionHandlers());
+}
+
+const CollisionHandlers& Fireflower::collisionHandlers()
+{
+    static constexpr auto handlers =
+            makeCollisionHandlers({{isMario, &Fireflower::onMario}});
+    static_assert(agreesWithCollisionMatrix(handlers, EntityType::FIREFLOWER),
+                  "Fireflower's handlers disagree with respondsToCollision()");
+    return handlers;
 }
 
 void Fireflower::doInternalCalculations()
@@ -44,13 +56,12 @@ void Fireflower::doInternalCalculations()
     }
 }
 
-void Fireflower::onCollision(const Collision& collision)
+void Fireflower::onMario(Entity& self, const Collision&)
 {
-    if (isMario(collision.entity->getType())) {
-        dispatchEvent(Event::constructPointsEarned({getTop(), getLeft()}, 1000));
-        terminate();
-    }
-
+    auto& fireflower = static_cast<Fireflower&>(self);
+    publishEvent(
+            Event::PointsEarned{{fireflower.getTop(), fireflower.getLeft()}, 1000});
+    fireflower.terminate();
 }
 
 void Fireflower::terminate()
@@ -78,6 +89,18 @@ Mushroom::Mushroom(const sf::Texture& texture,
             AnimationBuilder().withOffset(0, 0).withRectSize(16, 16).build(
                     mActiveSprite);
     mActiveAnimation = &defaultAnimation;
+    setCollisionHandlers(collisionHandlers());
+}
+
+const CollisionHandlers& Mushroom::collisionHandlers()
+{
+    static constexpr auto handlers = makeCollisionHandlers({
+            {isMario, &Mushroom::onMario},
+            {isObject, &Mushroom::onObject},
+    });
+    static_assert(agreesWithCollisionMatrix(handlers, EntityType::MUSHROOM),
+                  "Mushroom's handlers disagree with respondsToCollision()");
+    return handlers;
 }
 
 void Mushroom::doInternalCalculations()
@@ -96,39 +119,38 @@ void Mushroom::doInternalCalculations()
     }
 }
 
-void Mushroom::onCollision(const Collision& collision)
+void Mushroom::onMario(Entity& self, const Collision&)
 {
-    const auto hitbox = getHitbox(collision.entity->getType());
-
-    if (isObject(collision.entity->getType()))
-    {
-        const auto currentVelocity = getVelocity();
-        switch (collision.side)
-        {
-        case EntitySide::BOTTOM:
-            clampY(hitbox.getBottom(), collision.yIntersection);
-            setVelocity(sf::Vector2f(currentVelocity.x, 0));
-            break;
-        case EntitySide::LEFT:
-            clampX(hitbox.getLeft(), collision.xIntersection);
-            setVelocity(
-                    sf::Vector2f(currentVelocity.x * -1, currentVelocity.y));
-            break;
-        case EntitySide::RIGHT:
-            clampX(hitbox.getRight(), collision.xIntersection);
-            setVelocity(
-                    sf::Vector2f(currentVelocity.x * -1, currentVelocity.y));
-            break;
-        case EntitySide::TOP:
-            // do nothing
-            break;
-        }
-    }
+    auto& mushroom = static_cast<Mushroom&>(self);
+    publishEvent(
+            Event::PointsEarned{{mushroom.getTop(), mushroom.getLeft()}, 1000});
+    mushroom.terminate();
+}
 
-    if (isMario(collision.entity->getType()))
+void Mushroom::onObject(Entity& self, const Collision& collision)
+{
+    auto& mushroom = static_cast<Mushroom&>(self);
+    const auto hitbox = mushroom.mSpriteBoundsHitbox;
+    const auto currentVelocity = mushroom.getVelocity();
+    switch (collision.side)
     {
-        dispatchEvent(Event::constructPointsEarned({getTop(), getLeft()}, 1000));
-        terminate();
+    case EntitySide::BOTTOM:
+        mushroom.clampY(hitbox.getBottom(), collision.yIntersection);
+        mushroom.setVelocity(sf::Vector2f(currentVelocity.x, 0));
+        break;
+    case EntitySide::LEFT:
+        mushroom.clampX(hitbox.getLeft(), collision.xIntersection);
+        mushroom.setVelocity(
+                sf::Vector2f(currentVelocity.x * -1, currentVelocity.y));
+        break;
+    case EntitySide::RIGHT:
+        mushroom.clampX(hitbox.getRight(), collision.xIntersection);
+        mushroom.setVelocity(
+                sf::Vector2f(currentVelocity.x * -1, currentVelocity.y));
+        break;
+    case EntitySide::TOP:
+        // do nothing
+        break;
     }
 }
 
@@ -136,3 +158,33 @@ void Mushroom::terminate()
 {
     this->setCleanupFlag();
 }
+
+void Fireflower::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::FIREFLOWER;
+    state.anchor = mBlockTop;
+    saveAnimations(state, {&defaultAnimation});
+}
+
+void Fireflower::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    mBlockTop = state.anchor;
+    restoreAnimations(state, {&defaultAnimation});
+}
+
+void Mushroom::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::MUSHROOM;
+    state.anchor = mBlockTop;
+    saveAnimations(state, {&defaultAnimation});
+}
+
+void Mushroom::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    mBlockTop = state.anchor;
+    restoreAnimations(state, {&defaultAnimation});
+}
@@ -15,13 +15,19 @@ public:
              const sf::Vector2f& position,
              float blockTop);
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
 protected:
-    void onCollision(const Collision& collision) override;
     void terminate() override;
     void doInternalCalculations() override;
 
 private:
-    const float mBlockTop;
+    static const CollisionHandlers& collisionHandlers();
+    static void onMario(Entity& self, const Collision& collision);
+    static void onObject(Entity& self, const Collision& collision);
+
+    float mBlockTop;
     Animation defaultAnimation;
 };
 
@@ -35,13 +41,18 @@ public:
                const sf::Vector2f& position,
                float blockTop);
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
 protected:
-    void onCollision(const Collision& collision) override;
     void terminate() override;
     void doInternalCalculations() override;
 
 private:
-    const float mBlockTop;
+    static const CollisionHandlers& collisionHandlers();
+    static void onMario(Entity& self, const Collision& collision);
+
+    float mBlockTop;
     Animation defaultAnimation;
 };
 
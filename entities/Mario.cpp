@@ -5,11 +5,36 @@
 #include <cassert>
 
 #include "Animation.h"
+#include "EventBus.h"
 #include "Fireball.h"
 #include "Hitbox.h"
 #include "Level.h"
+#include "SaveState.h"
 #include "Timer.h"
 
+namespace
+{
+// Layout of EntityState::flags for Mario; the form goes in the high bits
+const uint32_t JUMPING_FLAG = 1 << 0;
+const uint32_t DEAD_FLAG = 1 << 1;
+const uint32_t SHOOTING_FLAG = 1 << 2;
+const uint32_t FORM_SHIFT = 8;
+
+EntityType formToType(MarioForm form)
+{
+    switch (form)
+    {
+    case MarioForm::BIG_MARIO:
+        return EntityType::BIG_MARIO;
+    case MarioForm::SMALL_MARIO:
+        return EntityType::SMALL_MARIO;
+    case MarioForm::FIRE_MARIO:
+        return EntityType::FIRE_MARIO;
+    }
+    throw std::runtime_error("Unhandled form in formToType()");
+}
+}
+
 const float Mario::MAX_RUNNING_VELOCITY = 4.0f;
 const float Mario::MAX_WALKING_VELOCITY = 1.5f;
 
@@ -88,6 +113,7 @@ Mario::Mario(const sf::Texture& texture, const sf::Vector2f& position) :
 
     mActiveAnimation = &standingAnimation;
     mActiveAnimation->processAction();
+    setCollisionHandlers(collisionHandlers());
 }
 
 const Hitbox& Mario::getHitbox(EntityType type) const
@@ -146,11 +172,14 @@ void Mario::setAnimationFromState()
             mActiveAnimation = &shootingAnimation;
             emitFireball();
             getTimer().scheduleSeconds(0.2,
-                                          [&]()
-                                          {
-                                              stopWalking();
-                                              mShooting = false;
-                                          });
+                                       [](Entity& owner)
+                                       {
+                                           auto& mario =
+                                                   static_cast<Mario&>(owner);
+                                           mario.stopWalking();
+                                           mario.mShooting = false;
+                                       },
+                                       *this);
         }
     }
     else
@@ -165,13 +194,30 @@ void Mario::setAnimationFromState()
     }
 }
 
+void Mario::setFireTransitionFrames(const sf::IntRect& startingRectangle)
+{
+    mFireTransitionStart = startingRectangle;
+
+    auto frameTwoRectangle(startingRectangle);
+    frameTwoRectangle.top += 128;
+    std::vector<sf::IntRect> changeToFireRectangles = {startingRectangle,
+                                                       frameTwoRectangle,
+                                                       startingRectangle,
+                                                       frameTwoRectangle,
+                                                       startingRectangle,
+                                                       frameTwoRectangle,
+                                                       startingRectangle,
+                                                       frameTwoRectangle};
+
+    changeToFireMarioAnimation.setActionRectangles(changeToFireRectangles);
+}
+
 void Mario::emitFireball()
 {
     const auto fireballX = mLookDirection < 0 ? getLeft() : getRight() - Fireball::width();
     const auto fireballY = screenYToSfmlY((getTop() + getBottom()) / 2);
-    dispatchEvent(Event::constructFireball(
-        sf::Vector2f(fireballX, fireballY),
-        mLookDirection));
+    publishEvent(Event::FireballSpawned{sf::Vector2f(fireballX, fireballY),
+                                        mLookDirection});
 }
 
 void Mario::walk()
@@ -212,9 +258,18 @@ void Mario::setForm(MarioForm form)
             mMarioCollisionHitbox = smallHitbox;
             updateHitboxPositions();
             mMarioCollisionHitbox.invalidate();
-            getTimer().scheduleSeconds(2,
-                                       [&]()
-                                       { mMarioCollisionHitbox.makeValid(); });
+
+            // Invincible for two seconds after shrinking
+            static const ScriptStep steps[] = {
+                    {60,
+                     [](Entity& owner)
+                     {
+                         static_cast<Mario&>(owner)
+                                 .mMarioCollisionHitbox.makeValid();
+                     }},
+            };
+            static const EntityScript invincibility(steps);
+            getTimer().runScript(invincibility, *this);
             standingAnimation.switchPalette(sf::Vector2f(80, 34),
                                             sf::Vector2f(16, 16));
             walkingAnimation.switchPalette(sf::Vector2f(80, 34),
@@ -227,23 +282,7 @@ void Mario::setForm(MarioForm form)
         case MarioForm::FIRE_MARIO:
         {
             // Frame 0
-            auto startingRectangle = mActiveAnimation->getCurrentFrame();
-
-            auto frameTwoRectangle(startingRectangle);
-            frameTwoRectangle.top += 128;
-            std::vector<sf::IntRect> changeToFireRectangles = {
-                    startingRectangle,
-                    frameTwoRectangle,
-                    startingRectangle,
-                    frameTwoRectangle,
-                    startingRectangle,
-                    frameTwoRectangle,
-                    startingRectangle,
-                    frameTwoRectangle};
-
-            changeToFireMarioAnimation.setActionRectangles(
-                    changeToFireRectangles);
-
+            setFireTransitionFrames(mActiveAnimation->getCurrentFrame());
             mActiveAnimation = &changeToFireMarioAnimation;
 
             standingAnimation.switchPalette(sf::Vector2f(80, 129),
@@ -257,23 +296,10 @@ void Mario::setForm(MarioForm form)
         }
 
         mForm = form;
+        setType(formToType(form));
     }
 }
 
-EntityType Mario::getType() const
-{
-    switch (mForm)
-    {
-    case MarioForm::BIG_MARIO:
-        return EntityType::BIG_MARIO;
-    case MarioForm::SMALL_MARIO:
-        return EntityType::SMALL_MARIO;
-    case MarioForm::FIRE_MARIO:
-        return EntityType::FIRE_MARIO;
-    }
-    throw std::runtime_error("Unhandled form in Mario::getType()");
-}
-
 void Mario::stopWalking()
 {
     mActiveAnimation = &standingAnimation;
@@ -298,79 +324,100 @@ std::string formToString(MarioForm form)
     return "";
 }
 
-void Mario::onCollision(const Collision& collision)
+const CollisionHandlers& Mario::collisionHandlers()
 {
-    // collision's side is referring to the side of Mario that collided
-    if (isEnemy(collision.entity->getType()))
-    {
-        if (collision.side != EntitySide::BOTTOM)
-        {
-            switch (mForm)
-            {
-            case MarioForm::SMALL_MARIO:
-                terminate();
-                break;
-            case MarioForm::BIG_MARIO:
-            case MarioForm::FIRE_MARIO:
-                setForm(MarioForm::SMALL_MARIO);
-                break;
-            }
-        }
-        else
-        {
-            addPositionDelta(0, -5);
-        }
-    }
-    else if (collision.entity->getType() == EntityType::MUSHROOM)
-    {
-        assert(mForm == MarioForm::SMALL_MARIO && formToString(mForm).c_str());
-        setForm(MarioForm::BIG_MARIO);
-    }
-    else if (collision.entity->getType() == EntityType::FIREFLOWER)
+    static constexpr auto handlers = makeCollisionHandlers({
+            {isEnemy, &Mario::onEnemy},
+            {EntityType::MUSHROOM, &Mario::onMushroom},
+            {EntityType::FIREFLOWER, &Mario::onFireflower},
+            {isObject, &Mario::onObject},
+    });
+    constexpr auto agrees = [](EntityType type)
+    { return agreesWithCollisionMatrix(handlers, type); };
+    static_assert(agrees(EntityType::SMALL_MARIO) &&
+                          agrees(EntityType::BIG_MARIO) &&
+                          agrees(EntityType::FIRE_MARIO),
+                  "Mario's handlers disagree with respondsToCollision()");
+    return handlers;
+}
+
+// In all of these, the collision's side is the side of Mario that collided
+void Mario::onEnemy(Entity& self, const Collision& collision)
+{
+    auto& mario = static_cast<Mario&>(self);
+    if (collision.side != EntitySide::BOTTOM)
     {
-        switch (mForm)
+        switch (mario.mForm)
         {
         case MarioForm::SMALL_MARIO:
-            setForm(MarioForm::BIG_MARIO);
+            mario.terminate();
             break;
         case MarioForm::BIG_MARIO:
-            setForm(MarioForm::FIRE_MARIO);
-            break;
         case MarioForm::FIRE_MARIO:
-            // TODO: Increase points
+            mario.setForm(MarioForm::SMALL_MARIO);
             break;
         }
     }
-    else if (isObject(collision.entity->getType()))
+    else
     {
-        // We're not colliding with an enemy, so we want the sprite
-        // hitbox
-        const auto& hitbox = getHitbox(collision.entity->getType());
-        const auto currentVelocity = getVelocity();
-        switch (collision.side)
-        {
-        case EntitySide::BOTTOM:
-            clampY(hitbox.getBottom(), collision.yIntersection);
-            setVelocity(sf::Vector2f(currentVelocity.x, 0));
-            setJumping(false);
-            break;
-        case EntitySide::TOP:
-            clampY(hitbox.getTop(), collision.yIntersection);
-            setVelocity(sf::Vector2f(currentVelocity.x, 0));
-            mAcceleration.y = GRAVITY_ACCELERATION;
-            mDeltaP.y = 0;
-            break;
-        case EntitySide::RIGHT:
-            clampX(hitbox.getRight(), collision.xIntersection);
-            setVelocity(sf::Vector2f(0, currentVelocity.y));
-            mAcceleration.x = 0;
-            break;
-        case EntitySide::LEFT:
-            clampX(hitbox.getLeft(), collision.xIntersection);
-            setVelocity(sf::Vector2f(0, currentVelocity.y));
-            mAcceleration.x = 0;
-            break;
-        }
+        mario.addPositionDelta(0, -5);
+    }
+}
+
+void Mario::onMushroom(Entity& self, const Collision&)
+{
+    auto& mario = static_cast<Mario&>(self);
+    assert(mario.mForm == MarioForm::SMALL_MARIO &&
+           formToString(mario.mForm).c_str());
+    mario.setForm(MarioForm::BIG_MARIO);
+}
+
+void Mario::onFireflower(Entity& self, const Collision&)
+{
+    auto& mario = static_cast<Mario&>(self);
+    switch (mario.mForm)
+    {
+    case MarioForm::SMALL_MARIO:
+        mario.setForm(MarioForm::BIG_MARIO);
+        break;
+    case MarioForm::BIG_MARIO:
+        mario.setForm(MarioForm::FIRE_MARIO);
+        break;
+    case MarioForm::FIRE_MARIO:
+        // TODO: Increase points
+        break;
+    }
+}
+
+void Mario::onObject(Entity& self, const Collision& collision)
+{
+    auto& mario = static_cast<Mario&>(self);
+    // We're not colliding with an enemy, so we want the sprite hitbox
+    const auto& hitbox = mario.mSpriteBoundsHitbox;
+    const auto currentVelocity = mario.getVelocity();
+    switch (collision.side)
+    {
+    case EntitySide::BOTTOM:
+        mario.clampY(hitbox.getBottom(), collision.yIntersection);
+        mario.setVelocity(sf::Vector2f(currentVelocity.x, 0));
+        mario.setJumping(false);
+        break;
+    case EntitySide::TOP:
+        mario.clampY(hitbox.getTop(), collision.yIntersection);
+        mario.setVelocity(sf::Vector2f(currentVelocity.x, 0));
+        mario.mAcceleration.y = mario.GRAVITY_ACCELERATION;
+        mario.mDeltaP.y = 0;
+        break;
+    case EntitySide::RIGHT:
+        mario.clampX(hitbox.getRight(), collision.xIntersection);
+        mario.setVelocity(sf::Vector2f(0, currentVelocity.y));
+        mario.mAcceleration.x = 0;
+        break;
+    case EntitySide::LEFT:
+        mario.clampX(hitbox.getLeft(), collision.xIntersection);
+        mario.setVelocity(sf::Vector2f(0, currentVelocity.y));
+        mario.mAcceleration.x = 0;
+        break;
     }
 }
 
@@ -382,12 +429,24 @@ void Mario::terminate()
     mAcceleration = {};
     mVelocity = {};
     mInputEnabled = false;
-    getTimer().scheduleSeconds(0.5,
-                               [&]()
-                               {
-                                   mVelocity.y = -10;
-                                   mAcceleration.y = GRAVITY_ACCELERATION;
-                               });
+
+    // Freeze for half a second, then hop up and fall off the screen
+    static const ScriptStep steps[] = {
+            {15,
+             [](Entity& owner)
+             {
+                 auto& mario = static_cast<Mario&>(owner);
+                 mario.mVelocity.y = -10;
+                 mario.mAcceleration.y = mario.GRAVITY_ACCELERATION;
+             }},
+    };
+    static const EntityScript deathHop(steps);
+    getTimer().runScript(deathHop, *this);
+}
+
+bool Mario::isDead() const
+{
+    return mIsDead;
 }
 
 bool Mario::isJumping() const
@@ -406,3 +465,43 @@ void Mario::shootFireball()
 {
     mShooting = true;
 }
+
+void Mario::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::MARIO;
+    saveAnimations(state,
+                   {&walkingAnimation,
+                    &jumpingAnimation,
+                    &standingAnimation,
+                    &deathAnimation,
+                    &shootingAnimation,
+                    &growingAnimation,
+                    &shrinkingAnimation,
+                    &changeToFireMarioAnimation});
+    state.flags = (mJumping ? JUMPING_FLAG : 0) | (mIsDead ? DEAD_FLAG : 0) |
+                  (mShooting ? SHOOTING_FLAG : 0) |
+                  (static_cast<uint32_t>(mForm) << FORM_SHIFT);
+    state.frame = mFireTransitionStart;
+}
+
+void Mario::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    if (state.frame != mFireTransitionStart)
+        setFireTransitionFrames(state.frame);
+    restoreAnimations(state,
+                      {&walkingAnimation,
+                       &jumpingAnimation,
+                       &standingAnimation,
+                       &deathAnimation,
+                       &shootingAnimation,
+                       &growingAnimation,
+                       &shrinkingAnimation,
+                       &changeToFireMarioAnimation});
+    mJumping = state.flags & JUMPING_FLAG;
+    mIsDead = state.flags & DEAD_FLAG;
+    mShooting = state.flags & SHOOTING_FLAG;
+    mForm = static_cast<MarioForm>(state.flags >> FORM_SHIFT);
+    setType(formToType(mForm));
+}
@@ -33,8 +33,6 @@ public:
     void setForm(MarioForm form);
     MarioForm getForm() const;
 
-    [[nodiscard]] EntityType getType() const override;
-
     void setAnimationFromState() override;
 
     inline void setJumping(bool isJumping)
@@ -44,6 +42,8 @@ public:
 
     void terminate() override;
 
+    bool isDead() const;
+
     bool isTransitioning() const;
 
     bool isJumping() const;
@@ -60,11 +60,21 @@ public:
 
     void shootFireball();
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
 private:
-    void onCollision(const Collision& collision) override;
+    static const CollisionHandlers& collisionHandlers();
+    static void onEnemy(Entity& self, const Collision& collision);
+    static void onMushroom(Entity& self, const Collision& collision);
+    static void onFireflower(Entity& self, const Collision& collision);
+    static void onObject(Entity& self, const Collision& collision);
 
     void emitFireball();
 
+    // Flash between the given frame and its fire palette
+    void setFireTransitionFrames(const sf::IntRect& startingRectangle);
+
     Hitbox smallHitbox;
     Hitbox largeHitbox;
 
@@ -79,6 +89,7 @@ private:
     Animation growingAnimation;
     Animation shrinkingAnimation;
     Animation changeToFireMarioAnimation;
+    sf::IntRect mFireTransitionStart;
 
     bool mJumping;
     bool mIsDead;
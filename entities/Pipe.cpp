@@ -1,6 +1,7 @@
 #include "Pipe.h"
 
 #include <AnimationBuilder.h>
+#include <SaveState.h>
 
 Pipe::Pipe(const sf::Texture& texture, const sf::Vector2f& position) :
     Entity(texture,
@@ -17,3 +18,16 @@ Pipe::Pipe(const sf::Texture& texture, const sf::Vector2f& position) :
                     mActiveSprite);
     mActiveAnimation = &defaultAnimation;
 }
+
+void Pipe::saveState(EntityState& state) const
+{
+    Entity::saveState(state);
+    state.kind = EntityKind::PIPE;
+    saveAnimations(state, {&defaultAnimation});
+}
+
+void Pipe::restoreState(const EntityState& state)
+{
+    Entity::restoreState(state);
+    restoreAnimations(state, {&defaultAnimation});
+}
@@ -8,6 +8,9 @@ class Pipe : public Entity
 public:
     Pipe(const sf::Texture& texture, const sf::Vector2f& position);
 
+    void saveState(EntityState& state) const override;
+    void restoreState(const EntityState& state) override;
+
 private:
     Animation defaultAnimation;
 };
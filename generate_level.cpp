@@ -0,0 +1,96 @@
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "LevelGenerator.h"
+
+/*
+ * Writes a generated stress level to a text level file, e.g.
+ *
+ *     generate_level big.txt seed=7 columns=20000 pipes=800 swarms=600
+ *
+ * The file can then be played, replayed or benchmarked like any other level.
+ */
+int main(int argc, char* argv[])
+{
+    LevelGeneratorOptions options;
+    const std::map<std::string, std::function<void(const std::string&)>>
+            setters = {
+                    {"seed",
+                     [&](const std::string& value)
+                     { options.seed = std::stoul(value); }},
+                    {"columns",
+                     [&](const std::string& value)
+                     { options.numColumns = std::stoul(value); }},
+                    {"ground",
+                     [&](const std::string& value)
+                     { options.groundDensity = std::stof(value); }},
+                    {"pipes",
+                     [&](const std::string& value)
+                     { options.numPipes = std::stoul(value); }},
+                    {"block_rows",
+                     [&](const std::string& value)
+                     { options.numBlockRows = std::stoul(value); }},
+                    {"blocks_per_row",
+                     [&](const std::string& value)
+                     { options.blocksPerRow = std::stoul(value); }},
+                    {"swarms",
+                     [&](const std::string& value)
+                     { options.numGoombaSwarms = std::stoul(value); }},
+                    {"swarm_size",
+                     [&](const std::string& value)
+                     { options.goombasPerSwarm = std::stoul(value); }},
+            };
+
+    const auto printUsage = [&]
+    {
+        std::cerr << "Usage: " << argv[0] << " <output> [name=value ...]\n"
+                  << "Names:";
+        for (const auto& setter : setters)
+            std::cerr << " " << setter.first;
+        std::cerr << "\n";
+    };
+
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        for (int ii = 2; ii < argc; ++ii)
+        {
+            const std::string argument = argv[ii];
+            const auto equals = argument.find('=');
+            const auto setter = setters.find(argument.substr(0, equals));
+            if (equals == std::string::npos || setter == setters.end())
+                throw std::runtime_error("Unknown option " + argument);
+            try
+            {
+                setter->second(argument.substr(equals + 1));
+            }
+            catch (const std::logic_error&)
+            {
+                // std::stoul() and std::stof() only name themselves
+                throw std::runtime_error("Bad value in " + argument);
+            }
+        }
+
+        std::ofstream output(argv[1]);
+        if (!output)
+            throw std::runtime_error(std::string("Unable to write ") +
+                                     argv[1]);
+        writeGeneratedLevel(options, output);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << "\n";
+        printUsage();
+        return 1;
+    }
+    return 0;
+}
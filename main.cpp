@@ -1,102 +1,208 @@
-#include <entities/Fireball.h>
-#include <entities/InvisibleWall.h>
 #include <file_util.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
 #include "ControllerOverlay.h"
 #include "Input.h"
+#include "InputQueue.h"
+#include "InputTape.h"
 #include "Level.h"
+#include "LevelFile.h"
+#include "Profiler.h"
 #include "SFML/Graphics.hpp"
 #include "SFML/Window.hpp"
 #include "SpriteMaker.h"
 #include "Text.h"
 #include "Timer.h"
-#include "entities/Block.h"
-#include "entities/Goomba.h"
-#include "entities/Ground.h"
-#include "entities/Mario.h"
-#include "entities/Pipe.h"
+
+namespace
+{
+const int MAX_RUN_AHEAD_FRAMES = 3;
+
+const auto FRAME_PERIOD = std::chrono::microseconds(1000000 / 30);
+
+// SFML events carry no time, so this is how late their stamps can be
+const auto INPUT_POLL_INTERVAL = std::chrono::milliseconds(1);
+
+int runAheadFramesFromEnvironment()
+{
+    const char* value = std::getenv("RUN_AHEAD");
+    if (value == nullptr)
+        return 0;
+    char* end = nullptr;
+    const long frames = std::strtol(value, &end, 10);
+    if (end == value || *end != '\0' || frames < 0 ||
+        frames > MAX_RUN_AHEAD_FRAMES)
+        throw std::runtime_error("RUN_AHEAD must be between 0 and " +
+                                 std::to_string(MAX_RUN_AHEAD_FRAMES));
+    return static_cast<int>(frames);
+}
+
+/*
+ * Draw the level as it will be numFrames from now if the current input is
+ * held, then go back. Hides numFrames of input latency, as emulators do.
+ */
+void drawAhead(Level& level,
+               const KeyboardInput& currentInput,
+               int numFrames,
+               LevelState& snapshot,
+               sf::RenderWindow& window)
+{
+    PROFILE_SCOPE("run-ahead");
+    level.saveState(snapshot);
+
+    auto heldInput = currentInput;
+    heldInput.updateWasDown(currentInput);
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        level.executeFrame(heldInput);
+        getTimer().incrementNumFrames();
+    }
+    level.drawFrame(window);
+
+    level.restoreState(snapshot);
+}
+}
 
 int main(int argc, char* argv[])
 {
     const auto root = findRootDirectory(argv[0]);
     const auto resourceDir = root + "resources/";
 
+    // Frames are paced by the game loop rather than setFramerateLimit(),
+    // which would sleep between drawing a frame and showing it
     sf::RenderWindow window(sf::VideoMode(200, 200), "Super Mario Bros");
-    window.setFramerateLimit(30);
     window.setSize(sf::Vector2u(960, 720));
     window.clear();
 
     initializeSpriteMaker(resourceDir);
     initializeHUDOverlay(resourceDir);
 
-    auto& spriteMaker = getSpriteMaker();
-
-    std::vector<std::unique_ptr<Entity>> entities;
-    entities.reserve(100);
-
-    std::unique_ptr<Mario> mario(
-            new Mario(spriteMaker->playerTexture, {60, 90}));
-    std::unique_ptr<Goomba> goomba(
-            new Goomba(spriteMaker->enemyTexture, {200, 50}));
-    std::unique_ptr<Pipe> rightPipe(
-            new Pipe(spriteMaker->inanimateObjectTexture, {130, 100}));
-    std::unique_ptr<Pipe> leftPipe(
-            new Pipe(spriteMaker->inanimateObjectTexture, {-10, 100}));
-
-    entities.push_back(std::move(leftPipe));
-    entities.push_back(std::move(rightPipe));
-    entities.push_back(std::move(goomba));
-
-    entities.push_back(
-            std::make_unique<InvisibleWall>(spriteMaker->inanimateObjectTexture,
-                                            sf::Vector2f(-16, -500)));
-    auto& wall = *(
-            dynamic_cast<InvisibleWall*>(entities[entities.size() - 1].get()));
-
-    for (int i = 0; i < 20; i++)
+    const auto levelPath =
+            argc > 1 ? std::string(argv[1]) : resourceDir + "levels/1-1.txt";
+    const auto levelFile = openLevelFile(levelPath);
+    auto level = loadLevel(levelFile, window.getView());
+
+    // Set RECORD_INPUT=<path> to save this session for the replay tool
+    std::unique_ptr<InputRecorder> recorder;
+    if (const char* recordPath = std::getenv("RECORD_INPUT"))
+        recorder = std::make_unique<InputRecorder>(recordPath);
+
+    // Set RUN_AHEAD=<1-3> to draw that many frames into the future
+    const int runAheadFrames = runAheadFramesFromEnvironment();
+    LevelState runAheadSnapshot;
+
+    // Set INPUT_LATENCY_LOG=<path> to log how long input takes to show
+    std::unique_ptr<LatencyLog> latencyLog;
+    if (const char* latencyPath = std::getenv("INPUT_LATENCY_LOG"))
+        latencyLog = std::make_unique<LatencyLog>(latencyPath);
+
+    // SFML only hands out a window's events on the thread that created it,
+    // so this thread collects them while the game runs and draws on its own
+    InputQueue inputQueue;
+    std::atomic<bool> running(true);
+    std::exception_ptr gameError;
+    const auto runGame = [&]
     {
-        entities.push_back(
-                std::make_unique<Ground>(spriteMaker->inanimateObjectTexture,
-                                         sf::Vector2f(i * 16, 132)));
-    }
-
-    entities.push_back(std::make_unique<BreakableBlock>(
-            spriteMaker->inanimateObjectTexture, sf::Vector2f(40, 75)));
-    entities.push_back(
-            std::make_unique<ItemBlock>(spriteMaker->inanimateObjectTexture,
-                                        sf::Vector2f(56, 75)));
-    entities.push_back(
-            std::make_unique<ItemBlock>(spriteMaker->inanimateObjectTexture,
-                                        sf::Vector2f(72, 75)));
+        window.setActive(true);
+        KeyboardInput currentInput = {};
+        KeyboardInput previousInput = {};
 
-    Level level(std::move(mario), std::move(entities), window, wall);
-
-    KeyboardInput currentInput = {};
-    KeyboardInput previousInput = {};
+        std::vector<KeyboardInput> keyboardInputs;
+#ifdef MANUAL_INPUT
+        size_t idx = 0;
+#endif
+        auto nextFrame = InputQueue::Clock::now();
+        while (running)
+        {
+            PROFILE_SCOPE("frame");
+            {
+                PROFILE_SCOPE("wait");
+                // Wait before taking the input rather than after drawing,
+                // so input arriving meanwhile is not left for the next frame
+                nextFrame += FRAME_PERIOD;
+                nextFrame = std::max(nextFrame, InputQueue::Clock::now());
+                std::this_thread::sleep_until(nextFrame);
+            }
+#ifdef MANUAL_INPUT
+            currentInput = nextInput(keyboardInputs, idx);
+            ++idx;
+#endif
+            const auto latched = inputQueue.latch(currentInput);
+            const auto latchTime = InputQueue::Clock::now();
+            currentInput.updateWasDown(previousInput);
+            previousInput = currentInput;
+            if (recorder)
+                recorder->record(currentInput);
+
+            level->executeFrame(currentInput);
+            if (runAheadFrames > 0)
+            {
+                getTimer().incrementNumFrames();
+                drawAhead(*level,
+                          currentInput,
+                          runAheadFrames,
+                          runAheadSnapshot,
+                          window);
+            }
+            else
+            {
+                level->drawFrame(window);
+                getTimer().incrementNumFrames();
+            }
+            {
+                PROFILE_SCOPE("overlay");
+                // Comment/uncomment line below to display in-game controller
+                ControllerOverlay::draw(currentInput, window);
+            }
+            {
+                PROFILE_SCOPE("display");
+                window.display();
+            }
+            if (latencyLog)
+                latencyLog->record(
+                        latched, latchTime, InputQueue::Clock::now());
+        }
+        window.setActive(false);
+    };
 
-    std::vector<KeyboardInput> keyboardInputs;
-    while (window.isOpen())
+    window.setActive(false);
+    std::thread gameThread(
+            [&]
+            {
+                try
+                {
+                    runGame();
+                }
+                catch (...)
+                {
+                    gameError = std::current_exception();
+                }
+                running = false;
+            });
+    while (running)
     {
         sf::Event event = {};
-#ifdef MANUAL_INPUT
-        currentInput = nextInput(keyboardInputs, idx);
-        ++idx;
-#endif
-        std::vector<sf::Keyboard::Key> keycodes;
         while (window.pollEvent(event))
         {
             switch (event.type)
             {
             case sf::Event::Closed:
-                window.close();
+                running = false;
                 break;
 #ifndef MANUAL_INPUT
             case sf::Event::KeyPressed:
-                currentInput.setKey(event.key.code, true);
+                inputQueue.push(event.key.code, true);
                 break;
             case sf::Event::KeyReleased:
             {
-                currentInput.setKey(event.key.code, false);
+                inputQueue.push(event.key.code, false);
                 break;
             }
 #endif
@@ -104,16 +210,16 @@ int main(int argc, char* argv[])
                 break;
             }
         }
-        currentInput.updateWasDown(previousInput);
-        previousInput = currentInput;
-
-        level.executeFrame(currentInput);
-        level.drawFrame(window);
-        // Comment/uncomment line below to display in-game controller
-        ControllerOverlay::draw(currentInput, window);
-        window.display();
-
-        getTimer().incrementNumFrames();
+        std::this_thread::sleep_for(INPUT_POLL_INTERVAL);
     }
+    gameThread.join();
+    window.close();
+    if (gameError)
+        std::rethrow_exception(gameError);
+
+#ifdef ENABLE_PROFILER
+    const char* profilePath = std::getenv("PROFILE_OUTPUT");
+    writeChromeTrace(profilePath ? profilePath : "profile.json");
+#endif
     return 0;
 }
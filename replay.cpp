@@ -0,0 +1,92 @@
+#include <file_util.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "InputTape.h"
+#include "Level.h"
+#include "LevelFile.h"
+#include "Profiler.h"
+#include "SpriteMaker.h"
+#include "Text.h"
+#include "Timer.h"
+
+/*
+ * Feeds a recorded input tape through a level as fast as possible, without
+ * a window, and reports the simulation speed and where Mario ended up.
+ * Record a tape by running the game with RECORD_INPUT=<path> set.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <level> <input tape> [--save-states]\n";
+        return 1;
+    }
+    const bool benchmarkSaveStates =
+            argc > 3 && std::string(argv[3]) == "--save-states";
+
+    const auto root = findRootDirectory(argv[0]);
+    initializeHeadlessSpriteMaker();
+    initializeHUDOverlay(root + "resources/");
+
+    const auto levelFile = openLevelFile(argv[1]);
+    auto level = loadLevel(levelFile);
+    auto tape = InputTape::load(argv[2]);
+
+    using Clock = std::chrono::steady_clock;
+    size_t numFrames = 0;
+    KeyboardInput input = {};
+    LevelState state;
+    size_t maxStateBytes = 0;
+    Clock::duration saveTime{};
+    Clock::duration restoreTime{};
+    const auto start = Clock::now();
+    while (tape.next(input))
+    {
+        // Save and restore every frame, as run-ahead would; the outcome must
+        // match a plain replay
+        if (benchmarkSaveStates)
+        {
+            const auto beforeSave = Clock::now();
+            level->saveState(state);
+            const auto beforeRestore = Clock::now();
+            level->restoreState(state);
+            restoreTime += Clock::now() - beforeRestore;
+            saveTime += beforeRestore - beforeSave;
+            maxStateBytes = std::max(maxStateBytes, state.getNumBytes());
+        }
+        level->executeFrame(input);
+        getTimer().incrementNumFrames();
+        ++numFrames;
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    const auto& mario = level->getMario();
+    std::cout << "Replayed " << numFrames << " frames in " << elapsed.count()
+              << "s (" << numFrames / elapsed.count() << " frames/s)\n"
+              << "Mario ended at (" << mario.getLeft() << ", "
+              << mario.getBottom() << ") as " << formToString(mario.getForm())
+              << "\n";
+
+    if (benchmarkSaveStates && numFrames > 0)
+    {
+        const auto microsecondsPerFrame = [&](Clock::duration total)
+        {
+            return std::chrono::duration<double, std::micro>(total).count() /
+                   numFrames;
+        };
+        std::cout << "Save states up to " << maxStateBytes << " bytes, save "
+                  << microsecondsPerFrame(saveTime) << "us, restore "
+                  << microsecondsPerFrame(restoreTime) << "us per frame\n";
+    }
+
+#ifdef ENABLE_PROFILER
+    const char* profilePath = std::getenv("PROFILE_OUTPUT");
+    writeChromeTrace(profilePath ? profilePath : "profile.json");
+#endif
+    return 0;
+}
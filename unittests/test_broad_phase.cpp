@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "BroadPhase.h"
+
+TEST(BoundsLanes, MaskMatchesOverlapsForEveryLane)
+{
+    // Eleven entities, so the second block has five padding lanes
+    const std::vector<BroadPhase::Bounds> entities{
+            {0, 0, 10, 10, false},
+            {10, 0, 20, 10, false},
+            {20.5f, 0, 30, 10, false},
+            {0, 10, 10, 20, false},
+            {-5, -5, -1, -1, false},
+            {0, 0, 0, 0, true},
+            {5, 5, 6, 6, false},
+            {-100, -100, 100, 100, false},
+            {11, 11, 12, 12, false},
+            {0, 10.5f, 10, 20, false},
+            {-1, 0, 0, 10, false}};
+    BoundsLanes lanes;
+    lanes.resize(entities.size());
+    for (size_t ii = 0; ii < entities.size(); ++ii)
+        lanes.set(ii, entities[ii]);
+    ASSERT_EQ(lanes.getNumBlocks(), 2u);
+
+    const BroadPhase::Bounds query{0, 0, 10, 10, false};
+    for (size_t block = 0; block < lanes.getNumBlocks(); ++block)
+    {
+        const auto mask = lanes.overlapMask(block, query);
+        for (size_t lane = 0; lane < BoundsLanes::LANES; ++lane)
+        {
+            const auto index = block * BoundsLanes::LANES + lane;
+            const auto expected = index < entities.size() &&
+                                  query.overlaps(entities[index]);
+            EXPECT_EQ(((mask >> lane) & 1) != 0, expected) << index;
+        }
+    }
+    EXPECT_EQ(lanes.overlapMask(0, BroadPhase::Bounds{0, 0, 0, 0, true}), 0u);
+    EXPECT_TRUE(lanes.get(5).isEmpty);
+    EXPECT_EQ(lanes.get(7).right, 100);
+}
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 #include "Level.h"
 #include "SpriteMaker.h"
+#include "Text.h"
 #include "entities/Goomba.h"
+#include "entities/Ground.h"
 #include "entities/Mario.h"
 #include "entities/Pipe.h"
 #include "file_util.h"
@@ -29,6 +31,43 @@ protected:
 
     ~EntityCollisionTest() override = default;
 };
+
+// Flies right far faster than anything in the game, and stops at the first
+// object it hits
+class Dart : public Entity
+{
+public:
+    explicit Dart(const sf::Vector2f& position) :
+        Entity(gSpriteMaker->itemAndObjectTexture,
+               16,
+               16,
+               Hitbox({16, 16}, {0, 0}),
+               EntityType::FIREBALL,
+               position)
+    {
+        mAcceleration = {};
+        mVelocity = {60, 0};
+        setCollisionHandlers(collisionHandlers());
+    }
+
+    std::vector<uint32_t> mHits;
+
+private:
+    static const CollisionHandlers& collisionHandlers()
+    {
+        static constexpr auto handlers =
+                makeCollisionHandlers({{isObject, &Dart::onObject}});
+        return handlers;
+    }
+
+    static void onObject(Entity& self, const Collision& collision)
+    {
+        auto& dart = static_cast<Dart&>(self);
+        dart.mHits.push_back(collision.entity->getId());
+        dart.clampX(dart.getRight(), collision.xIntersection);
+        dart.mVelocity = {};
+    }
+};
 }
 
 TEST_F(EntityCollisionTest, MarioCanWalkOnPipe)
@@ -82,11 +121,97 @@ TEST_F(EntityCollisionTest, MarioCanStandOnEdgeOfPipe)
     EXPECT_EQ(200.f, level.getMario().getBottom());
 }
 
+TEST_F(EntityCollisionTest, FastFallDoesNotTunnelThroughGround)
+{
+    Ground ground(gSpriteMaker->inanimateObjectTexture, {30, 132});
+    const auto groundTop = ground.getTop();
+
+    // Far more than a frame's fall at MAX_FALLING_VELOCITY; Mario ends up
+    // entirely below the tile
+    mario->mDeltaP = {};
+    mario->addPositionDelta(0, 60);
+    ASSERT_GT(mario->getTop(), ground.getBottom());
+
+    EXPECT_TRUE(mario->collideWithEntity(ground));
+    EXPECT_EQ(mario->getBottom(), groundTop);
+}
+
+TEST_F(EntityCollisionTest, ResolvedCollisionsAreRecordedInOrder)
+{
+    // Enough tiles for the level to go through the broad phase
+    std::vector<std::unique_ptr<Entity>> entities;
+    for (int ii = 0; ii < 80; ++ii)
+        entities.push_back(std::make_unique<Ground>(
+                gSpriteMaker->inanimateObjectTexture,
+                sf::Vector2f(16.f * ii, 200)));
+    std::vector<uint32_t> goombaIds;
+    for (int ii = 0; ii < 4; ++ii)
+    {
+        entities.push_back(std::make_unique<Goomba>(
+                gSpriteMaker->enemyTexture, sf::Vector2f(300.f * ii, 150)));
+        goombaIds.push_back(entities.back()->getId());
+    }
+
+    Level level(std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                        sf::Vector2f(5, 100)),
+                std::move(entities));
+    level.setActivityMargin(1e9);
+
+    std::vector<uint32_t> landed;
+    for (int frame = 0; frame < 100; ++frame)
+    {
+        level.executeFrame({});
+        for (const auto& collision : level.getResolvedCollisions())
+        {
+            const auto goomba = std::find(
+                    goombaIds.begin(), goombaIds.end(), collision.entityId);
+            if (goomba != goombaIds.end() &&
+                collision.side == EntitySide::BOTTOM &&
+                std::find(landed.begin(), landed.end(), *goomba) ==
+                        landed.end())
+                landed.push_back(*goomba);
+        }
+    }
+
+    // They all fall the same way, so they land in the same frame and are
+    // resolved in entity order
+    EXPECT_EQ(landed, goombaIds);
+}
+
+TEST_F(EntityCollisionTest, FastMoverStopsAtTheFirstHitboxInItsWay)
+{
+    // The far tile comes first in pair order, and the dart ends the frame
+    // inside it after passing straight through the near one
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.push_back(std::make_unique<Ground>(
+            gSpriteMaker->inanimateObjectTexture, sf::Vector2f(60, 40)));
+    const auto farId = entities.back()->getId();
+    entities.push_back(std::make_unique<Ground>(
+            gSpriteMaker->inanimateObjectTexture, sf::Vector2f(30, 40)));
+    const auto nearId = entities.back()->getId();
+    entities.push_back(std::make_unique<Dart>(sf::Vector2f(0, 40)));
+    const auto* dart = static_cast<Dart*>(entities.back().get());
+
+    Level level(std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                        sf::Vector2f(5, 100)),
+                std::move(entities));
+    for (int frame = 0; frame < 3; ++frame)
+        level.executeFrame({});
+
+    // The far tile's handler never runs, not even in a later frame
+    EXPECT_EQ(std::count(dart->mHits.begin(), dart->mHits.end(), farId), 0);
+    EXPECT_EQ(dart->mHits, std::vector<uint32_t>({nearId}));
+    EXPECT_EQ(dart->getRight(), 30.f);
+}
+
 int main(int argc, char** argv)
 {
     std::cout << "Running main() from gtest_main.cc\n";
     ::testing::GTEST_FLAG(output) = "xml:hello.xml";
     testing::InitGoogleTest(&argc, argv);
-    gSpriteMaker = new SpriteMaker(findRootDirectory(argv[0]) + "resources/");
+    const auto resourcesDir = findRootDirectory(argv[0]) + "resources/";
+    gSpriteMaker = new SpriteMaker(resourcesDir);
+    initializeSpriteMaker(resourcesDir);
+    initializeHUDOverlay(resourcesDir);
     return RUN_ALL_TESTS();
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "EventBus.h"
+
+TEST(EventBus, HandsOverEachTypeAsOneBatch)
+{
+    EventBus bus;
+    std::vector<std::vector<int>> batches;
+    int numShattered = 0;
+    bus.subscribe<Event::PointsEarned>(
+            [&](const std::vector<Event::PointsEarned>& events)
+            {
+                batches.emplace_back();
+                for (const auto& event : events)
+                    batches.back().push_back(event.points);
+            },
+            &batches);
+    bus.subscribe<Event::BlockShattered>(
+            [&](const std::vector<Event::BlockShattered>& events)
+            { numShattered += events.size(); },
+            &batches);
+
+    bus.publish(Event::PointsEarned{{0, 0}, 100});
+    bus.publish(Event::BlockShattered{{0, 0}});
+    bus.publish(Event::PointsEarned{{0, 0}, 50});
+    bus.dispatch();
+    EXPECT_EQ(batches, std::vector<std::vector<int>>({{100, 50}}));
+    EXPECT_EQ(numShattered, 1);
+
+    // Nothing is handed over twice, and empty channels are skipped
+    bus.dispatch();
+    EXPECT_EQ(batches.size(), 1u);
+    EXPECT_EQ(numShattered, 1);
+}
+
+TEST(EventBus, UnsubscribeDropsEveryChannelOfTheOwner)
+{
+    EventBus bus;
+    int kept = 0;
+    int dropped = 0;
+    bus.subscribe<Event::PointsEarned>(
+            [&](const std::vector<Event::PointsEarned>&) { ++kept; }, &kept);
+    bus.subscribe<Event::PointsEarned>(
+            [&](const std::vector<Event::PointsEarned>&) { ++dropped; },
+            &dropped);
+    bus.subscribe<Event::FireballSpawned>(
+            [&](const std::vector<Event::FireballSpawned>&) { ++dropped; },
+            &dropped);
+
+    bus.unsubscribe(&dropped);
+    bus.publish(Event::PointsEarned{{0, 0}, 100});
+    bus.publish(Event::FireballSpawned{{0, 0}, 1});
+    bus.dispatch();
+    EXPECT_EQ(kept, 1);
+    EXPECT_EQ(dropped, 0);
+    EXPECT_TRUE(bus.channel<Event::FireballSpawned>().getPending().empty());
+}
+
+TEST(EventBus, HandlesEventsRaisedDuringDispatch)
+{
+    EventBus bus;
+    std::vector<int> handled;
+    // Every event raises three more, one level deeper, so each batch is
+    // read while a bigger one is published
+    const size_t fanOut = 3;
+    bus.subscribe<Event::PointsEarned>(
+            [&](const std::vector<Event::PointsEarned>& events)
+            {
+                for (const auto& event : events)
+                {
+                    handled.push_back(event.points);
+                    for (size_t ii = 0; ii < fanOut; ++ii)
+                        bus.publish(Event::PointsEarned{{0, 0},
+                                                        event.points + 1});
+                }
+            },
+            &handled);
+
+    bus.publish(Event::PointsEarned{{0, 0}, 0});
+    bus.dispatch();
+
+    // Every level up to the bound is handled in the same dispatch, in order
+    std::vector<int> expected;
+    size_t levelSize = 1;
+    for (size_t depth = 0; depth < EventBus::MAX_DISPATCH_DEPTH; ++depth)
+    {
+        expected.insert(expected.end(), levelSize, static_cast<int>(depth));
+        levelSize *= fanOut;
+    }
+    EXPECT_EQ(handled, expected);
+
+    // and the level raised after that waits for the next dispatch
+    const auto& pending = bus.channel<Event::PointsEarned>().getPending();
+    ASSERT_EQ(pending.size(), levelSize);
+    EXPECT_EQ(pending.front().points,
+              static_cast<int>(EventBus::MAX_DISPATCH_DEPTH));
+}
+
+TEST(EventBus, MergesStagesInStageOrder)
+{
+    EventBus bus;
+    bus.setNumStages(2);
+    std::vector<int> handled;
+    bus.subscribe<Event::PointsEarned>(
+            [&](const std::vector<Event::PointsEarned>& events)
+            {
+                for (const auto& event : events)
+                    handled.push_back(event.points);
+            },
+            &handled);
+
+    // Stage 1 finishes before stage 0 even starts
+    std::thread second(
+            [&]
+            {
+                ScopedEventStage stage(bus, 1);
+                bus.publish(Event::PointsEarned{{0, 0}, 10});
+                bus.publish(Event::PointsEarned{{0, 0}, 11});
+            });
+    second.join();
+    std::thread first(
+            [&]
+            {
+                ScopedEventStage stage(bus, 0);
+                bus.publish(Event::PointsEarned{{0, 0}, 0});
+            });
+    first.join();
+
+    // Threads without a stage publish straight onto the channel
+    bus.publish(Event::PointsEarned{{0, 0}, 100});
+    EXPECT_EQ(bus.channel<Event::PointsEarned>().getPending().size(), 1u);
+
+    bus.mergeStages();
+    bus.dispatch();
+    EXPECT_EQ(handled, std::vector<int>({100, 0, 10, 11}));
+}
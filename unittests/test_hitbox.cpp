@@ -39,3 +39,37 @@ TEST_F(HitboxTest, InvalidateHitbox)
     EXPECT_EQ(hitbox->mUpperLeftOffset.x, -10000.f);
     EXPECT_EQ(hitbox->mUpperLeftOffset.y, -10000.f);
 }
+
+TEST(HitboxSweep, FindsHitboxPassedStraightThrough)
+{
+    Hitbox moving({16, 16}, {0, 0});
+    moving.setEntityPosition({0, 0});
+    Hitbox thin({16, 4}, {0, 0});
+    thin.setEntityPosition({0, 40});
+
+    // The end position is already past the thin hitbox
+    const sf::Vector2f delta(0, 60);
+    moving.setEntityPosition(delta);
+    EXPECT_FALSE(moving.collidesWith(thin));
+    moving.setEntityPosition({0, 0});
+
+    float timeOfImpact = -1;
+    auto side = EntitySide::TOP;
+    ASSERT_TRUE(moving.sweepInto(thin, delta, timeOfImpact, side));
+    EXPECT_FLOAT_EQ(timeOfImpact, 0.4f);
+    EXPECT_EQ(side, EntitySide::BOTTOM);
+}
+
+TEST(HitboxSweep, MissesHitboxOutOfReach)
+{
+    Hitbox moving({16, 16}, {0, 0});
+    moving.setEntityPosition({0, 0});
+    Hitbox thin({16, 4}, {0, 0});
+    thin.setEntityPosition({0, 40});
+
+    float timeOfImpact;
+    EntitySide side;
+    EXPECT_FALSE(moving.sweepInto(thin, {0, 20}, timeOfImpact, side));
+    // Passing beside it
+    EXPECT_FALSE(moving.sweepInto(thin, {60, 60}, timeOfImpact, side));
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "InputQueue.h"
+
+TEST(InputQueue, LatchAppliesEventsInArrivalOrder)
+{
+    InputQueue queue;
+    const auto start = InputQueue::Clock::now();
+    queue.push({sf::Keyboard::Right, true, start});
+    queue.push({sf::Keyboard::A, true, start + std::chrono::milliseconds(1)});
+    queue.push({sf::Keyboard::A, false, start + std::chrono::milliseconds(2)});
+
+    KeyboardInput input = {};
+    input.left.keyIsDown = true;
+    const auto latched = queue.latch(input);
+    EXPECT_EQ(latched.numEvents, 3u);
+    EXPECT_EQ(latched.oldestEvent, start);
+    EXPECT_TRUE(input.right.keyIsDown);
+    EXPECT_FALSE(input.A.keyIsDown);
+    EXPECT_TRUE(input.left.keyIsDown);
+
+    // Nothing is latched twice
+    EXPECT_EQ(queue.latch(input).numEvents, 0u);
+    EXPECT_TRUE(input.right.keyIsDown);
+}
+
+TEST(InputQueue, EventsFromAnotherThreadAreLatched)
+{
+    InputQueue queue;
+    std::thread window(
+            [&queue]
+            {
+                for (int ii = 0; ii < 1000; ++ii)
+                    queue.push(sf::Keyboard::S, ii % 2 == 0);
+            });
+    size_t numLatched = 0;
+    KeyboardInput input = {};
+    while (numLatched < 1000)
+        numLatched += queue.latch(input).numEvents;
+    window.join();
+    EXPECT_EQ(numLatched, 1000u);
+    EXPECT_FALSE(input.B.keyIsDown);
+}
+
+TEST(LatencyLog, WritesOneLinePerFrame)
+{
+    const std::string path = testing::TempDir() + "latency.csv";
+    const auto latchTime = InputQueue::Clock::now();
+    const auto displayTime = latchTime + std::chrono::microseconds(2500);
+    {
+        LatencyLog log(path);
+        log.record({0, {}}, latchTime, displayTime);
+        log.record({2, latchTime - std::chrono::microseconds(10000)},
+                   latchTime,
+                   displayTime);
+    }
+
+    std::ifstream input(path);
+    std::string line;
+    std::getline(input, line);
+    EXPECT_EQ(line, "frame,events,input_to_display_us,latch_to_display_us");
+    std::getline(input, line);
+    EXPECT_EQ(line, "0,0,,2500");
+    std::getline(input, line);
+    EXPECT_EQ(line, "1,2,12500,2500");
+    std::remove(path.c_str());
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "InputTape.h"
+
+namespace
+{
+bool sameInput(const KeyboardInput& lhs, const KeyboardInput& rhs)
+{
+    return packInput(lhs) == packInput(rhs);
+}
+}
+
+TEST(InputTape, PackingRoundTrips)
+{
+    for (uint32_t packed = 0; packed <= 0xffff; ++packed)
+        EXPECT_EQ(packInput(unpackInput(packed)), packed);
+
+    KeyboardInput input = {};
+    input.right.keyIsDown = true;
+    input.B.keyIsDown = true;
+    input.B.keyWasDown = true;
+    const auto unpacked = unpackInput(packInput(input));
+    EXPECT_TRUE(unpacked.right.keyIsDown);
+    EXPECT_FALSE(unpacked.right.keyWasDown);
+    EXPECT_TRUE(unpacked.B.keyIsDown);
+    EXPECT_TRUE(unpacked.B.keyWasDown);
+    EXPECT_FALSE(unpacked.A.keyIsDown);
+}
+
+TEST(InputTape, RecordedInputsReplayInOrder)
+{
+    const std::string path = testing::TempDir() + "recorded.tape";
+
+    KeyboardInput running = {};
+    running.right.keyIsDown = true;
+    KeyboardInput jumping = running;
+    jumping.A.keyIsDown = true;
+
+    std::vector<KeyboardInput> inputs(1000, running);
+    for (size_t ii = 400; ii < 430; ++ii)
+        inputs[ii] = jumping;
+    {
+        InputRecorder recorder(path);
+        for (const auto& input : inputs)
+            recorder.record(input);
+    }
+
+    // Three runs: header plus a few bytes per run
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    EXPECT_LE(file.tellg(), 6 + 3 * 5);
+
+    auto tape = InputTape::load(path);
+    EXPECT_EQ(tape.getNumFrames(), inputs.size());
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        KeyboardInput input = {};
+        for (const auto& expected : inputs)
+        {
+            ASSERT_TRUE(tape.next(input));
+            EXPECT_TRUE(sameInput(input, expected));
+        }
+        EXPECT_FALSE(tape.next(input));
+        tape.rewind();
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+#include "JobSystem.h"
+
+TEST(JobSystem, RunsEveryItemOnceInFixedChunks)
+{
+    JobSystem jobSystem(3);
+    const size_t count = 1000;
+    const size_t grainSize = 64;
+    std::vector<std::atomic<int>> runs(count);
+    std::vector<size_t> chunkOf(count);
+    jobSystem.parallelFor(count,
+                          grainSize,
+                          [&](size_t begin, size_t end, size_t chunk)
+                          {
+                              for (auto ii = begin; ii < end; ++ii)
+                              {
+                                  ++runs[ii];
+                                  chunkOf[ii] = chunk;
+                              }
+                          });
+
+    EXPECT_EQ(JobSystem::countChunks(count, grainSize), 16u);
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        EXPECT_EQ(runs[ii], 1);
+        EXPECT_EQ(chunkOf[ii], ii / grainSize);
+    }
+}
+
+TEST(JobSystem, WithoutWorkersRunsChunksInOrder)
+{
+    JobSystem jobSystem(0);
+    std::vector<size_t> chunks;
+    jobSystem.parallelFor(10,
+                          3,
+                          [&](size_t, size_t, size_t chunk)
+                          { chunks.push_back(chunk); });
+    EXPECT_EQ(chunks, std::vector<size_t>({0, 1, 2, 3}));
+}
+
+TEST(JobSystem, RethrowsOnceEveryChunkHasFinished)
+{
+    JobSystem jobSystem(2);
+    std::atomic<int> numFinished(0);
+    EXPECT_THROW(jobSystem.parallelFor(
+                         8,
+                         1,
+                         [&](size_t begin, size_t, size_t)
+                         {
+                             if (begin == 3)
+                                 throw std::runtime_error("chunk failed");
+                             ++numFinished;
+                         }),
+                 std::runtime_error);
+    EXPECT_EQ(numFinished, 7);
+
+    // and the pool is still usable afterwards
+    jobSystem.parallelFor(8, 1, [&](size_t, size_t, size_t) { ++numFinished; });
+    EXPECT_EQ(numFinished, 15);
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Level.h"
+#include "SpriteMaker.h"
+#include "entities/Block.h"
+#include "entities/Fireball.h"
+#include "entities/Goomba.h"
+#include "entities/Ground.h"
+
+extern SpriteMaker* gSpriteMaker;
+
+namespace
+{
+// Lies still until a fireball wakes it
+class Sleeper : public Entity
+{
+public:
+    explicit Sleeper(const sf::Vector2f& position) :
+        Entity(gSpriteMaker->enemyTexture,
+               16,
+               16,
+               Hitbox({16, 16}, {0, 0}),
+               EntityType::GOOMBA,
+               position)
+    {
+        mAcceleration = {};
+        setCollisionHandlers(collisionHandlers());
+    }
+
+private:
+    static const CollisionHandlers& collisionHandlers()
+    {
+        static constexpr auto handlers = makeCollisionHandlers(
+                {{EntityType::FIREBALL, &Sleeper::onFireball}});
+        return handlers;
+    }
+
+    static void onFireball(Entity& self, const Collision&)
+    {
+        self.setVelocity({0, 0.5f});
+    }
+};
+
+bool wasResolved(const Level& level, const Entity& entity, const Entity& other)
+{
+    for (const auto& collision : level.getResolvedCollisions())
+    {
+        if ((collision.entityId == entity.getId() &&
+             collision.otherId == other.getId()) ||
+            (collision.entityId == other.getId() &&
+             collision.otherId == entity.getId()))
+            return true;
+    }
+    return false;
+}
+}
+
+TEST(LevelActivity, EntitiesBeyondTheMarginFreezeAndResume)
+{
+    auto mario = std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                         sf::Vector2f(20, 60));
+    auto* marioPointer = mario.get();
+    std::vector<std::unique_ptr<Entity>> entities;
+    for (const auto x : {0.f, 16.f, 32.f, 480.f, 496.f, 512.f, 528.f})
+        entities.push_back(std::make_unique<Ground>(
+                gSpriteMaker->inanimateObjectTexture, sf::Vector2f(x, 150)));
+    // The view spans x 0 to 200, so this is 400 pixels past its edge
+    entities.push_back(std::make_unique<Goomba>(gSpriteMaker->enemyTexture,
+                                                sf::Vector2f(600, 100)));
+    const auto* goomba = entities.back().get();
+    Level level(std::move(mario), std::move(entities));
+    level.setActivityMargin(64);
+
+    const auto position = sf::Vector2f(goomba->getLeft(), goomba->getTop());
+    const auto velocity = goomba->getVelocity();
+    for (int frame = 0; frame < 60; ++frame)
+    {
+        level.executeFrame({});
+        EXPECT_EQ(goomba->getLeft(), position.x);
+        EXPECT_EQ(goomba->getTop(), position.y);
+        EXPECT_EQ(goomba->getVelocity(), velocity);
+    }
+
+    // The camera follows Mario until the Goomba is within the margin
+    marioPointer->setPosition(500, 100);
+    level.executeFrame({});
+    const auto& camera = level.getCamera();
+    ASSERT_GE(camera.getCenter().x + camera.getSize().x / 2 + 64, position.x);
+
+    // Carries on from where it stopped, one frame's worth of movement
+    EXPECT_NE(goomba->getLeft(), position.x);
+    EXPECT_LT(std::abs(goomba->getLeft() - position.x), 4);
+    EXPECT_LT(std::abs(goomba->getTop() - position.y), 4);
+}
+
+TEST(LevelActivity, BumpedBlockWakesAndSettlesBackToSleep)
+{
+    std::vector<std::unique_ptr<Entity>> entities;
+    for (const auto x : {0.f, 16.f, 32.f, 48.f})
+        entities.push_back(std::make_unique<Ground>(
+                gSpriteMaker->inanimateObjectTexture, sf::Vector2f(x, 150)));
+    entities.push_back(std::make_unique<BreakableBlock>(
+            gSpriteMaker->inanimateObjectTexture, sf::Vector2f(20, 90)));
+    const auto* block = entities.back().get();
+    Level level(std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                        sf::Vector2f(20, 120)),
+                std::move(entities));
+
+    const auto top = block->getTop();
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        level.executeFrame({});
+        EXPECT_TRUE(block->isAsleep());
+    }
+
+    KeyboardInput jump = {};
+    jump.A.keyIsDown = true;
+    int frame = 0;
+    for (; frame < 30 && block->isAsleep(); ++frame)
+        level.executeFrame(jump);
+    ASSERT_FALSE(block->isAsleep()) << "Mario never hit the block";
+
+    auto highest = top;
+    for (frame = 0; frame < 60 && !block->isAsleep(); ++frame)
+    {
+        level.executeFrame({});
+        EXPECT_LE(block->getTop(), top);
+        highest = std::min(highest, block->getTop());
+    }
+    EXPECT_LT(highest, top);
+    EXPECT_TRUE(block->isAsleep());
+    EXPECT_EQ(block->getTop(), top);
+}
+
+TEST(LevelActivity, EntitiesWokenByAPairResponseCollideFromTheNextFrame)
+{
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.push_back(std::make_unique<Ground>(
+            gSpriteMaker->inanimateObjectTexture, sf::Vector2f(16, 150)));
+    // Resting on the ground and sunk into it, but asleep, so the overlap
+    // is never tested
+    entities.push_back(std::make_unique<Sleeper>(sf::Vector2f(150, 140)));
+    const auto* sleeper = entities.back().get();
+    entities.push_back(std::make_unique<Fireball>(
+            gSpriteMaker->itemAndObjectTexture, sf::Vector2f(160, 144), -1));
+    const auto* fireball = entities.back().get();
+    entities.push_back(std::make_unique<Ground>(
+            gSpriteMaker->inanimateObjectTexture, sf::Vector2f(150, 150)));
+    const auto* ground = entities.back().get();
+    Level level(std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                        sf::Vector2f(20, 120)),
+                std::move(entities));
+
+    // Which entities are asleep is settled before the pairs are resolved,
+    // so the sleeper the fireball wakes still skips the ground this frame
+    level.executeFrame({});
+    EXPECT_TRUE(wasResolved(level, *sleeper, *fireball));
+    EXPECT_FALSE(sleeper->isAsleep());
+    EXPECT_FALSE(wasResolved(level, *sleeper, *ground));
+
+    level.executeFrame({});
+    EXPECT_TRUE(wasResolved(level, *sleeper, *ground));
+}
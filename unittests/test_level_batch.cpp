@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "JobSystem.h"
+#include "LevelBatch.h"
+#include "LevelFile.h"
+#include "test_levels.h"
+
+TEST(LevelBatch, InstancesMatchLevelsRunOnTheirOwn)
+{
+    const auto levelFile = LevelFile::fromText(LEVEL_TEXT);
+    const size_t numInstances = 6;
+    const int numFrames = 300;
+
+    LevelBatch batch(numInstances,
+                     [&levelFile] { return loadLevel(levelFile); });
+    std::vector<KeyboardInput> inputs(numInstances);
+    std::vector<size_t> totalRewards(numInstances);
+    const size_t gridSize = 16 * 14;
+    std::vector<uint8_t> observations(numInstances * gridSize);
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        for (size_t ii = 0; ii < numInstances; ++ii)
+            inputs[ii] = scriptedInput(ii, frame, inputs[ii]);
+        batch.step(inputs);
+        batch.writeObservations(observations.data(), 16, 14);
+        for (size_t ii = 0; ii < numInstances; ++ii)
+            totalRewards[ii] += static_cast<size_t>(batch.getRewards()[ii]);
+    }
+
+    for (size_t ii = 0; ii < numInstances; ++ii)
+    {
+        // A fresh context, as each of the batch's instances has
+        Timer timer;
+        EventBus eventBus;
+        JobSystem jobSystem(0);
+        const SimulationContext context{&timer, &eventBus, &jobSystem};
+        ScopedSimulationContext scope(context);
+        auto level = loadLevel(levelFile);
+        KeyboardInput input = {};
+        for (int frame = 0; frame < numFrames && !level->getMario().isDead();
+             ++frame)
+        {
+            input = scriptedInput(ii, frame, input);
+            level->executeFrame(input);
+            timer.incrementNumFrames();
+        }
+
+        const auto& mario = level->getMario();
+        const auto& batchMario = batch.getLevel(ii).getMario();
+        EXPECT_EQ(batchMario.getLeft(), mario.getLeft()) << "Instance " << ii;
+        EXPECT_EQ(batchMario.getBottom(), mario.getBottom())
+                << "Instance " << ii;
+        EXPECT_EQ(batch.getScores()[ii], level->getPoints());
+        EXPECT_EQ(totalRewards[ii], level->getPoints());
+        EXPECT_EQ(batch.getDone()[ii] != 0, mario.isDead());
+
+        std::vector<uint8_t> observation(gridSize);
+        level->writeObservation(observation.data(), 16, 14);
+        EXPECT_TRUE(std::equal(observation.begin(),
+                               observation.end(),
+                               observations.begin() + ii * gridSize))
+                << "Instance " << ii;
+    }
+    EXPECT_GT(*std::max_element(totalRewards.begin(), totalRewards.end()), 0u);
+}
+
+TEST(LevelBatch, ResetStartsAnInstanceOver)
+{
+    const auto levelFile = LevelFile::fromText(LEVEL_TEXT);
+    LevelBatch batch(2, [&levelFile] { return loadLevel(levelFile); });
+    const auto startLeft = batch.getLevel(0).getMario().getLeft();
+
+    std::vector<KeyboardInput> inputs(2);
+    inputs[0].right.keyIsDown = true;
+    for (int frame = 0; frame < 30; ++frame)
+        batch.step(inputs);
+    EXPECT_GT(batch.getLevel(0).getMario().getLeft(), startLeft);
+
+    batch.reset(0);
+    EXPECT_EQ(batch.getLevel(0).getMario().getLeft(), startLeft);
+    EXPECT_EQ(batch.getScores()[0], 0u);
+    EXPECT_FALSE(batch.getDone()[0]);
+}
+
+TEST(LevelBatch, NeedsOneInputPerInstance)
+{
+    const auto levelFile = LevelFile::fromText(LEVEL_TEXT);
+    LevelBatch batch(3, [&levelFile] { return loadLevel(levelFile); });
+    EXPECT_THROW(batch.step(std::vector<KeyboardInput>(2)),
+                 std::runtime_error);
+}
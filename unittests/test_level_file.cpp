@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "LevelFile.h"
+
+TEST(LevelFile, CompilesSpawnsAndTileRowsSortedByX)
+{
+    const auto levelFile = LevelFile::fromText(
+            "# comment\n"
+            "mario 60 90\n"
+            "goomba 200 50\n"
+            "pipe 130 100  # trailing comment\n"
+            "ground 16 132 20\n"
+            "ground 0 148 4\n");
+
+    EXPECT_EQ(levelFile.getMarioPosition(), sf::Vector2f(60, 90));
+
+    ASSERT_EQ(levelFile.getNumSpawns(), 2u);
+    const auto* spawns = levelFile.spawnsBegin();
+    EXPECT_EQ(spawns[0].kind, SpawnKind::PIPE);
+    EXPECT_EQ(spawns[0].x, 130);
+    EXPECT_EQ(spawns[0].y, 100);
+    EXPECT_EQ(spawns[1].kind, SpawnKind::GOOMBA);
+    EXPECT_EQ(spawns[1].x, 200);
+
+    ASSERT_EQ(levelFile.getNumTileRows(), 2u);
+    const auto* rows = levelFile.tileRowsBegin();
+    EXPECT_EQ(rows[0].x, 0);
+    EXPECT_EQ(rows[0].count, 4);
+    EXPECT_EQ(rows[1].x, 16);
+    EXPECT_EQ(rows[1].y, 132);
+    EXPECT_EQ(rows[1].count, 20);
+}
+
+TEST(LevelFile, RejectsMalformedText)
+{
+    std::istringstream unknown("mario 0 0\nkoopa 10 10\n");
+    EXPECT_THROW(compileLevelText(unknown), std::runtime_error);
+
+    std::istringstream missingMario("goomba 10 10\n");
+    EXPECT_THROW(compileLevelText(missingMario), std::runtime_error);
+
+    std::istringstream missingCount("mario 0 0\nground 0 132\n");
+    EXPECT_THROW(compileLevelText(missingCount), std::runtime_error);
+}
+
+TEST(LevelFile, RejectsTruncatedBinary)
+{
+    std::istringstream input("mario 0 0\ngoomba 10 10\n");
+    auto compiled = compileLevelText(input);
+    compiled.pop_back();
+    EXPECT_THROW(LevelFile::fromBuffer(compiled), std::runtime_error);
+}
+
+TEST(LevelFile, MapsCompiledFile)
+{
+    std::istringstream input("mario 8 16\nitem_block 56 75\n");
+    const auto compiled = compileLevelText(input);
+
+    const std::string path = testing::TempDir() + "level_file_test.lvl";
+    {
+        std::ofstream output(path, std::ios::binary);
+        output.write(compiled.data(), compiled.size());
+    }
+
+    const auto levelFile = LevelFile::map(path);
+    EXPECT_EQ(levelFile.getMarioPosition(), sf::Vector2f(8, 16));
+    ASSERT_EQ(levelFile.getNumSpawns(), 1u);
+    EXPECT_EQ(levelFile.spawnsBegin()->kind, SpawnKind::ITEM_BLOCK);
+    EXPECT_EQ(levelFile.getNumTileRows(), 0u);
+    std::remove(path.c_str());
+}
+
+TEST(LevelFile, RecompilesTextEditedRightAfterCompiling)
+{
+    const std::string path = testing::TempDir() + "level_file_edit.txt";
+    const std::string compiledPath =
+            testing::TempDir() + "level_file_edit.lvl";
+    std::remove(compiledPath.c_str());
+    {
+        std::ofstream output(path);
+        output << "mario 8 16\n";
+    }
+    EXPECT_EQ(openLevelFile(path).getNumSpawns(), 0u);
+
+    // Well within the second the cache was written in
+    {
+        std::ofstream output(path);
+        output << "mario 8 16\ngoomba 10 10\n";
+    }
+    EXPECT_EQ(openLevelFile(path).getNumSpawns(), 1u);
+
+    // The cache is complete and nothing is left beside it
+    EXPECT_EQ(LevelFile::map(compiledPath).getNumSpawns(), 1u);
+    std::ifstream temp(compiledPath + ".tmp" +
+                       std::to_string(static_cast<long>(getpid())));
+    EXPECT_FALSE(temp);
+    std::remove(path.c_str());
+    std::remove(compiledPath.c_str());
+}
+
+TEST(LevelFile, RecompilesCacheFromAnOlderVersion)
+{
+    const std::string path = testing::TempDir() + "level_file_old.txt";
+    const std::string compiledPath =
+            testing::TempDir() + "level_file_old.lvl";
+    {
+        std::ofstream output(path);
+        output << "mario 8 16\ngoomba 10 10\n";
+    }
+
+    // Newer than the text, so only its version gives it away
+    std::istringstream input("mario 8 16\n");
+    auto compiled = compileLevelText(input);
+    --reinterpret_cast<LevelFileHeader*>(compiled.data())->version;
+    {
+        std::ofstream output(compiledPath, std::ios::binary);
+        output.write(compiled.data(), compiled.size());
+    }
+    ASSERT_THROW(LevelFile::map(compiledPath), std::runtime_error);
+
+    EXPECT_EQ(openLevelFile(path).getNumSpawns(), 1u);
+    EXPECT_EQ(LevelFile::map(compiledPath).getNumSpawns(), 1u);
+    std::remove(path.c_str());
+    std::remove(compiledPath.c_str());
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "Level.h"
+#include "LevelGenerator.h"
+
+namespace
+{
+std::string generateText(const LevelGeneratorOptions& options)
+{
+    std::ostringstream text;
+    writeGeneratedLevel(options, text);
+    return text.str();
+}
+
+size_t countSpawns(const LevelFile& levelFile, SpawnKind kind)
+{
+    return std::count_if(levelFile.spawnsBegin(),
+                         levelFile.spawnsEnd(),
+                         [&](const SpawnRecord& spawn)
+                         { return spawn.kind == kind; });
+}
+
+size_t countTiles(const LevelFile& levelFile)
+{
+    size_t numTiles = 0;
+    for (auto row = levelFile.tileRowsBegin(); row != levelFile.tileRowsEnd();
+         ++row)
+        numTiles += row->count;
+    return numTiles;
+}
+}
+
+TEST(LevelGenerator, SameSeedGivesSameLevel)
+{
+    LevelGeneratorOptions options;
+    options.seed = 42;
+    EXPECT_EQ(generateText(options), generateText(options));
+
+    auto otherOptions = options;
+    otherOptions.seed = 43;
+    EXPECT_NE(generateText(options), generateText(otherOptions));
+}
+
+TEST(LevelGenerator, PlacesRequestedFeatures)
+{
+    LevelGeneratorOptions options;
+    options.numColumns = 5000;
+    options.groundDensity = 0.5f;
+    options.numPipes = 100;
+    options.numBlockRows = 50;
+    options.blocksPerRow = 3;
+    options.numGoombaSwarms = 40;
+    options.goombasPerSwarm = 5;
+    const auto levelFile = generateLevelFile(options);
+
+    EXPECT_EQ(countSpawns(levelFile, SpawnKind::PIPE), 100u);
+    EXPECT_EQ(countSpawns(levelFile, SpawnKind::GOOMBA), 200u);
+    EXPECT_EQ(countSpawns(levelFile, SpawnKind::BREAKABLE_BLOCK) +
+                      countSpawns(levelFile, SpawnKind::ITEM_BLOCK),
+              150u);
+
+    // Roughly half the columns have ground, and the last tile ends in time
+    EXPECT_GT(countTiles(levelFile), 2200u);
+    EXPECT_LT(countTiles(levelFile), 2800u);
+    const auto& lastRow = *(levelFile.tileRowsEnd() - 1);
+    EXPECT_LE(lastRow.x + lastRow.count * GRIDBOX_SIZE,
+              5000 * GRIDBOX_SIZE);
+}
+
+TEST(LevelGenerator, RejectsLevelsTooShortForTheirFeatures)
+{
+    LevelGeneratorOptions options;
+    options.numColumns = 20;
+    options.numPipes = 10;
+    EXPECT_THROW(generateLevelFile(options), std::runtime_error);
+}
+
+TEST(LevelGenerator, GeneratedLevelIsFullyResident)
+{
+    LevelGeneratorOptions options;
+    options.numColumns = 1000;
+    const auto levelFile = generateLevelFile(options);
+    const auto level = generateLevel(options);
+
+    LevelState state;
+    level->saveState(state);
+    // Everything in the level file plus the invisible wall
+    EXPECT_EQ(state.entities.size(),
+              levelFile.getNumSpawns() + countTiles(levelFile) + 1);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "LevelStreamer.h"
+#include "SpriteMaker.h"
+
+extern SpriteMaker* gSpriteMaker;
+
+namespace
+{
+LevelFile compileLongLevel(int numTiles)
+{
+    std::ostringstream text;
+    text << "mario 0 100\n";
+    text << "ground 0 132 " << numTiles << "\n";
+    for (int x = 64; x < numTiles * GRIDBOX_SIZE; x += 64)
+        text << "goomba " << x << " 116\n";
+
+    return LevelFile::fromText(text.str());
+}
+}
+
+TEST(LevelStreamer, LoadsOnlyChunksAheadOfTheView)
+{
+    const auto levelFile = compileLongLevel(1000);
+    LevelStreamer streamer(levelFile, *gSpriteMaker);
+    std::vector<std::unique_ptr<Entity>> entities;
+
+    streamer.loadAhead(200, entities);
+    EXPECT_EQ(streamer.getLoadedUntil(), 2 * LevelStreamer::CHUNK_WIDTH);
+    for (const auto& entity : entities)
+        EXPECT_LT(entity->getLeft(), streamer.getLoadedUntil());
+
+    // Two chunks of ground plus the Goombas near the right edge of the view
+    EXPECT_EQ(entities.size(), 32u + 3u);
+}
+
+TEST(LevelStreamer, SpawnsEnemiesOnlyAsTheViewApproaches)
+{
+    const auto levelFile = compileLongLevel(1000);
+    LevelStreamer streamer(levelFile, *gSpriteMaker);
+    std::vector<std::unique_ptr<Entity>> entities;
+
+    const auto countGoombas = [&]()
+    {
+        return std::count_if(entities.begin(),
+                             entities.end(),
+                             [](const std::unique_ptr<Entity>& entity)
+                             { return entity->getType() == EntityType::GOOMBA; });
+    };
+
+    streamer.loadAhead(200, entities);
+    EXPECT_EQ(countGoombas(), 3);
+
+    // The Goomba at x = 256 appears once it is within the spawn margin
+    streamer.loadAhead(256 - LevelStreamer::ENEMY_SPAWN_MARGIN - 1, entities);
+    EXPECT_EQ(countGoombas(), 3);
+    streamer.loadAhead(256 - LevelStreamer::ENEMY_SPAWN_MARGIN, entities);
+    EXPECT_EQ(countGoombas(), 4);
+}
+
+TEST(LevelStreamer, ResidentEntitiesStayBoundedOnLongLevels)
+{
+    const auto levelFile = compileLongLevel(5000);
+    LevelStreamer streamer(levelFile, *gSpriteMaker);
+    std::vector<std::unique_ptr<Entity>> entities;
+
+    size_t maxResident = 0;
+    for (float viewLeft = 0; viewLeft < 5000 * GRIDBOX_SIZE; viewLeft += 50)
+    {
+        LevelStreamer::unloadBehind(viewLeft, entities, nullptr);
+        streamer.loadAhead(viewLeft + 200, entities);
+        maxResident = std::max(maxResident, entities.size());
+
+        for (const auto& entity : entities)
+            EXPECT_GE(entity->getRight(), viewLeft - LevelStreamer::CHUNK_WIDTH);
+    }
+
+    EXPECT_TRUE(streamer.isExhausted());
+    // At most the chunk holding the view's left edge plus three more
+    EXPECT_LE(maxResident, 4u * (16 + 4));
+}
+
+TEST(LevelStreamer, KeepsPinnedEntity)
+{
+    const auto levelFile = compileLongLevel(100);
+    LevelStreamer streamer(levelFile, *gSpriteMaker);
+    std::vector<std::unique_ptr<Entity>> entities;
+    streamer.loadAhead(200, entities);
+
+    const Entity* pinned = entities.front().get();
+    LevelStreamer::unloadBehind(10000, entities, pinned);
+    ASSERT_EQ(entities.size(), 1u);
+    EXPECT_EQ(entities.front().get(), pinned);
+}
@@ -0,0 +1,36 @@
+#ifndef SUPERMARIOBROS_TEST_LEVELS_H
+#define SUPERMARIOBROS_TEST_LEVELS_H
+
+#include <cstddef>
+
+#include "Input.h"
+
+// A small level shared by the tests that play whole frames. Mario grabs the
+// mushroom from the first item block and runs off the end of the ground, so
+// the streamer drops most of the level behind him.
+const char* const LEVEL_TEXT =
+        "mario 60 90\n"
+        "pipe -10 100\n"
+        "pipe 130 100\n"
+        "goomba 200 50\n"
+        "ground 0 132 20\n"
+        "breakable_block 40 75\n"
+        "item_block 56 75\n"
+        "item_block 72 75\n";
+
+/*
+ * Run right and jump on a fixed rhythm. Each instance of a batch is offset
+ * so they don't all play the same game.
+ */
+inline KeyboardInput scriptedInput(size_t instance,
+                                   int frame,
+                                   const KeyboardInput& previous)
+{
+    KeyboardInput input = {};
+    input.right.keyIsDown = (frame + 11 * instance) % 120 < 90;
+    input.A.keyIsDown = (frame + 5 * instance) % 37 < 12;
+    input.updateWasDown(previous);
+    return input;
+}
+
+#endif  // SUPERMARIOBROS_TEST_LEVELS_H
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "Level.h"
+#include "SpriteMaker.h"
+#include "entities/Goomba.h"
+#include "entities/Ground.h"
+
+extern SpriteMaker* gSpriteMaker;
+
+namespace
+{
+const size_t WIDTH = 16;
+const size_t HEIGHT = 14;
+const float CELL_SIZE = 16;
+
+uint8_t cellValue(EntityType type)
+{
+    return static_cast<uint8_t>(static_cast<size_t>(type) + 1);
+}
+
+// The cell holding the given point, with the grid centered on the camera
+size_t cellAt(const Level& level, float x, float y)
+{
+    const auto& center = level.getCamera().getCenter();
+    const auto column =
+            static_cast<size_t>((x - center.x) / CELL_SIZE + WIDTH / 2.f);
+    const auto row =
+            static_cast<size_t>((y - center.y) / CELL_SIZE + HEIGHT / 2.f);
+    return row * WIDTH + column;
+}
+}
+
+TEST(Observation, MarksTheCellsEntitiesCover)
+{
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.push_back(std::make_unique<Ground>(
+            gSpriteMaker->inanimateObjectTexture, sf::Vector2f(64, 150)));
+    const auto* ground = entities.back().get();
+    // Far outside the activity window, so never looked at
+    entities.push_back(std::make_unique<Goomba>(gSpriteMaker->enemyTexture,
+                                                sf::Vector2f(5000, 100)));
+    // Active, but off the sides of the grid
+    entities.push_back(std::make_unique<Goomba>(gSpriteMaker->enemyTexture,
+                                                sf::Vector2f(-70, 100)));
+    entities.push_back(std::make_unique<Goomba>(gSpriteMaker->enemyTexture,
+                                                sf::Vector2f(260, 100)));
+    Level level(std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                        sf::Vector2f(20, 60)),
+                std::move(entities));
+
+    std::vector<uint8_t> cells(WIDTH * HEIGHT, 0xff);
+    level.writeObservation(cells.data(), WIDTH, HEIGHT, CELL_SIZE);
+
+    const auto& mario = level.getMario();
+    EXPECT_EQ(cells[cellAt(level, ground->getLeft() + 1, ground->getTop() + 1)],
+              cellValue(EntityType::GROUND));
+    EXPECT_EQ(cells[cellAt(level, mario.getLeft() + 1, mario.getTop() + 1)],
+              cellValue(mario.getType()));
+    EXPECT_EQ(std::count(cells.begin(),
+                         cells.end(),
+                         cellValue(EntityType::GOOMBA)),
+              0);
+    EXPECT_EQ(cells[0], Level::EMPTY_CELL);
+}
+
+TEST(Observation, ZeroSizedGridWritesNothing)
+{
+    Level level(std::make_unique<Mario>(gSpriteMaker->playerTexture,
+                                        sf::Vector2f(20, 60)),
+                {});
+    uint8_t cell = 0xff;
+    level.writeObservation(&cell, 0, 1);
+    EXPECT_EQ(cell, 0xff);
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <sstream>
+#include <thread>
+
+TEST(Profiler, DumpsScopesFromEveryThread)
+{
+    {
+        PROFILE_SCOPE("test outer");
+        PROFILE_SCOPE("test inner");
+    }
+    std::thread([]() { PROFILE_SCOPE("test worker"); }).join();
+
+    std::ostringstream trace;
+    writeChromeTrace(trace);
+    const auto json = trace.str();
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("\"name\":\"test outer\",\"ph\":\"X\""),
+              std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"test inner\""), std::string::npos);
+
+    // The worker ran on a thread of its own
+    const auto worker = json.find("\"name\":\"test worker\"");
+    ASSERT_NE(worker, std::string::npos);
+    EXPECT_EQ(json.find("\"tid\":0", worker), std::string::npos);
+}
+
+#endif  // ENABLE_PROFILER
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "Level.h"
+#include "LevelFile.h"
+#include "Timer.h"
+#include "test_levels.h"
+
+namespace
+{
+struct FrameSummary
+{
+    float left;
+    float bottom;
+    MarioForm form;
+    size_t numEntities;
+    size_t points;
+
+    bool operator==(const FrameSummary& other) const
+    {
+        return left == other.left && bottom == other.bottom &&
+               form == other.form && numEntities == other.numEntities &&
+               points == other.points;
+    }
+};
+
+FrameSummary runFrame(Level& level, int frame, KeyboardInput& previous)
+{
+    previous = scriptedInput(0, frame, previous);
+    level.executeFrame(previous);
+    getTimer().incrementNumFrames();
+
+    LevelState state;
+    level.saveState(state);
+    const auto& mario = level.getMario();
+    return {mario.getLeft(),
+            mario.getBottom(),
+            mario.getForm(),
+            state.entities.size(),
+            state.points};
+}
+}
+
+TEST(SaveState, RestoredLevelReplaysIdentically)
+{
+    const auto levelFile = LevelFile::fromText(LEVEL_TEXT);
+    auto level = loadLevel(levelFile);
+
+    const int snapshotFrame = 30;
+    const int numFrames = 400;
+    KeyboardInput previous = {};
+    for (int frame = 0; frame < snapshotFrame; ++frame)
+        runFrame(*level, frame, previous);
+
+    LevelState snapshot;
+    level->saveState(snapshot);
+    const auto previousAtSnapshot = previous;
+
+    std::vector<FrameSummary> original;
+    for (int frame = snapshotFrame; frame < numFrames; ++frame)
+        original.push_back(runFrame(*level, frame, previous));
+
+    // The run must have destroyed entities, so restoring rebuilds them
+    EXPECT_EQ(original.front().points, 0u);
+    EXPECT_GT(original.back().points, 0u);
+    EXPECT_LT(original.back().numEntities, snapshot.entities.size());
+
+    level->restoreState(snapshot);
+    previous = previousAtSnapshot;
+    for (int frame = snapshotFrame; frame < numFrames; ++frame)
+    {
+        const auto summary = runFrame(*level, frame, previous);
+        ASSERT_TRUE(summary == original[frame - snapshotFrame])
+                << "Diverged at frame " << frame;
+    }
+}
+
+TEST(SaveState, RejectsStateFromAnotherLevel)
+{
+    const auto levelFile = LevelFile::fromText(LEVEL_TEXT);
+    auto level = loadLevel(levelFile);
+    auto otherLevel = loadLevel(levelFile);
+
+    LevelState state;
+    otherLevel->saveState(state);
+    EXPECT_THROW(level->restoreState(state), std::runtime_error);
+}
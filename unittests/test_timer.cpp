@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include "Entity.h"
 #include "Timer.h"
 
 TEST(Timer, ExecuteCallbackAfterOneSecond)
@@ -27,3 +28,94 @@ TEST(Timer, CannotExecuteCallback)
 
 
 
+
+TEST(Timer, CancelledCallbacksNeverRun)
+{
+    Timer timer;
+    size_t dummy = 0;
+    int owner = 0;
+    timer.scheduleSeconds(1, [&]() { dummy = 1; }, &owner);
+    timer.scheduleSeconds(1, [&]() { dummy += 2; });
+    timer.cancel(&owner);
+    for (size_t i = 0; i <= timer.FRAMES_PER_SECOND; i++)
+    {
+        timer.incrementNumFrames();
+    }
+    EXPECT_EQ(dummy, 2);
+}
+
+TEST(Timer, ScriptRunsItsStepsInOrder)
+{
+    Timer timer;
+    timer.numFrames = 0;
+    const sf::Texture texture;
+    Entity entity(texture,
+                  16,
+                  16,
+                  Hitbox({16, 16}, {0, 0}),
+                  EntityType::GOOMBA,
+                  {0, 0});
+    static const ScriptStep steps[] = {
+            {2, [](Entity& owner) { owner.setVelocity({1, 0}); }},
+            {3, [](Entity& owner) { owner.setVelocity({2, 0}); }},
+    };
+    static const EntityScript script(steps);
+    timer.runScript(script, entity);
+
+    std::vector<float> velocities;
+    for (int i = 0; i < 7; i++)
+    {
+        timer.incrementNumFrames();
+        velocities.push_back(entity.getVelocity().x);
+    }
+    EXPECT_EQ(velocities, std::vector<float>({0, 0, 1, 1, 1, 2, 2}));
+    // The whole script was one entry, gone after the last step
+    EXPECT_TRUE(timer.scheduledTimes.empty());
+}
+
+TEST(Timer, CallbacksCanCancelWhileTheTimerFires)
+{
+    Timer timer;
+    timer.numFrames = 0;
+    const sf::Texture texture;
+    Entity entity(texture,
+                  16,
+                  16,
+                  Hitbox({16, 16}, {0, 0}),
+                  EntityType::GOOMBA,
+                  {0, 0});
+    static const ScriptStep steps[] = {
+            {1, [](Entity& owner) { owner.setVelocity({1, 0}); }},
+            {1, [](Entity& owner) { owner.setVelocity({2, 0}); }},
+    };
+    static const EntityScript script(steps);
+
+    // Fired last to first, so the callback cancels entries on both sides
+    // of the script, itself included, just before the script's first step
+    int first = 0;
+    int second = 0;
+    timer.scheduleSeconds(
+            1.0 / timer.FRAMES_PER_SECOND, [&] { ++first; }, &first);
+    timer.runScript(script, entity);
+    timer.scheduleSeconds(
+            1.0 / timer.FRAMES_PER_SECOND,
+            [&]
+            {
+                ++second;
+                timer.cancel(&first);
+                timer.cancel(&second);
+            },
+            &second);
+
+    timer.incrementNumFrames();
+    timer.incrementNumFrames();
+    EXPECT_EQ(first, 0);
+    EXPECT_EQ(second, 1);
+    EXPECT_EQ(entity.getVelocity().x, 1);
+    ASSERT_EQ(timer.scheduledTimes.size(), 1u);
+    EXPECT_EQ(timer.scheduledTimes[0].mStep, 1u);
+
+    timer.incrementNumFrames();
+    EXPECT_EQ(entity.getVelocity().x, 2);
+    EXPECT_TRUE(timer.scheduledTimes.empty());
+}